@@ -30,6 +30,10 @@ struct bio_alloc_cache {
 	unsigned int		nr;
 };
 
+#define ALLOC_CACHE_MAX		512
+#define ALLOC_CACHE_SLACK	 64
+#define ALLOC_CACHE_REFILL	 16
+
 static struct biovec_slab {
 	int nr_vecs;
 	char *name;
@@ -408,6 +412,44 @@ static void punt_bios_to_rescuer(struct bio_set *bs)
 	queue_work(bs->rescue_workqueue, &bs->rescue_work);
 }
 
+/*
+ * Refill an empty per-cpu cache with one bulk slab allocation rather than
+ * going through the mempool, and thus the slab fast path, once per bio.
+ * Returns one bio for the caller and stashes the rest in the cache.
+ */
+static struct bio *bio_alloc_cache_refill(struct bio_set *bs, gfp_t gfp)
+{
+	void *objs[ALLOC_CACHE_REFILL];
+	struct bio_alloc_cache *cache;
+	int i, nr;
+
+	/* opportunistic, the mempool fallback deals with memory pressure */
+	gfp = (gfp & ~__GFP_DIRECT_RECLAIM) | __GFP_NOWARN;
+	nr = kmem_cache_alloc_bulk(bs->bio_slab, gfp, ALLOC_CACHE_REFILL, objs);
+	if (!nr)
+		return NULL;
+
+	for (i = 0; i < nr; i++) {
+		struct bio *bio = objs[i] + bs->front_pad;
+
+		/* make the bio safe to bio_free() if the cache gets pruned */
+		bio_init(bio, NULL, NULL, 0, 0);
+		bio->bi_pool = bs;
+		objs[i] = bio;
+	}
+
+	cache = per_cpu_ptr(bs->cache, get_cpu());
+	for (i = 1; i < nr; i++) {
+		struct bio *bio = objs[i];
+
+		bio->bi_next = cache->free_list;
+		cache->free_list = bio;
+		cache->nr++;
+	}
+	put_cpu();
+	return objs[0];
+}
+
 static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 		unsigned short nr_vecs, blk_opf_t opf, gfp_t gfp,
 		struct bio_set *bs)
@@ -418,13 +460,17 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 	cache = per_cpu_ptr(bs->cache, get_cpu());
 	if (!cache->free_list) {
 		put_cpu();
-		return NULL;
+		bio = bio_alloc_cache_refill(bs, gfp);
+		if (!bio)
+			return NULL;
+		goto init;
 	}
 	bio = cache->free_list;
 	cache->free_list = bio->bi_next;
 	cache->nr--;
 	put_cpu();
 
+init:
 	bio_init(bio, bdev, nr_vecs ? bio->bi_inline_vecs : NULL, nr_vecs, opf);
 	bio->bi_pool = bs;
 	return bio;
@@ -676,9 +722,6 @@ void guard_bio_eod(struct bio *bio)
 	bio_truncate(bio, maxsector << 9);
 }
 
-#define ALLOC_CACHE_MAX		512
-#define ALLOC_CACHE_SLACK	 64
-
 static void bio_alloc_cache_prune(struct bio_alloc_cache *cache,
 				  unsigned int nr)
 {
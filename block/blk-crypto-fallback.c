@@ -183,30 +183,6 @@ static struct bio *blk_crypto_fallback_clone_bio(struct bio *bio_src)
 	return bio;
 }
 
-static bool
-blk_crypto_fallback_alloc_cipher_req(struct blk_crypto_keyslot *slot,
-				     struct skcipher_request **ciph_req_ret,
-				     struct crypto_wait *wait)
-{
-	struct skcipher_request *ciph_req;
-	const struct blk_crypto_fallback_keyslot *slotp;
-	int keyslot_idx = blk_crypto_keyslot_index(slot);
-
-	slotp = &blk_crypto_keyslots[keyslot_idx];
-	ciph_req = skcipher_request_alloc(slotp->tfms[slotp->crypto_mode],
-					  GFP_NOIO);
-	if (!ciph_req)
-		return false;
-
-	skcipher_request_set_callback(ciph_req,
-				      CRYPTO_TFM_REQ_MAY_BACKLOG |
-				      CRYPTO_TFM_REQ_MAY_SLEEP,
-				      crypto_req_done, wait);
-	*ciph_req_ret = ciph_req;
-
-	return true;
-}
-
 static bool blk_crypto_fallback_split_bio_if_needed(struct bio **bio_ptr)
 {
 	struct bio *bio = *bio_ptr;
@@ -251,6 +227,185 @@ static void blk_crypto_dun_to_iv(const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE],
 		iv->dun[i] = cpu_to_le64(dun[i]);
 }
 
+/*
+ * Maximum number of data units kept in flight per bio when the keyslot's
+ * skcipher is asynchronous.  Synchronous skciphers complete each request
+ * before returning, so they only ever get a single request.
+ */
+#define BLK_CRYPTO_FALLBACK_MAX_INFLIGHT	16
+
+struct blk_crypto_fallback_unit {
+	struct scatterlist src;
+	struct scatterlist dst;
+	union blk_crypto_iv iv;
+	struct skcipher_request *req;
+};
+
+/*
+ * A batch of data units that are submitted to the skcipher back to back and
+ * waited for together.  With an asynchronous (e.g. hardware offload or cryptd)
+ * implementation this keeps the engine busy instead of waiting for each data
+ * unit in turn.
+ */
+struct blk_crypto_fallback_batch {
+	bool encrypt;
+	unsigned int nr_units;
+	unsigned int nr_queued;
+	/* one reference per request in flight, plus one held by the submitter */
+	atomic_t pending;
+	int err;
+	struct completion done;
+	struct blk_crypto_fallback_unit units[];
+};
+
+static void
+blk_crypto_fallback_unit_done(struct blk_crypto_fallback_batch *batch, int err)
+{
+	/* keep the first error */
+	if (err)
+		cmpxchg(&batch->err, 0, err);
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+static void blk_crypto_fallback_req_done(struct crypto_async_request *areq,
+					 int err)
+{
+	/* a backlogged request was moved onto the queue, wait for the result */
+	if (err == -EINPROGRESS)
+		return;
+	blk_crypto_fallback_unit_done(areq->data, err);
+}
+
+static size_t blk_crypto_fallback_batch_size(unsigned int nr_units,
+					     unsigned int req_size)
+{
+	struct blk_crypto_fallback_batch *batch;
+
+	return ALIGN(struct_size(batch, units, nr_units), CRYPTO_MINALIGN) +
+		nr_units * req_size;
+}
+
+static struct blk_crypto_fallback_batch *
+blk_crypto_fallback_alloc_batch(struct blk_crypto_keyslot *slot, bool encrypt)
+{
+	const struct blk_crypto_fallback_keyslot *slotp =
+		&blk_crypto_keyslots[blk_crypto_keyslot_index(slot)];
+	struct crypto_skcipher *tfm = slotp->tfms[slotp->crypto_mode];
+	struct blk_crypto_fallback_batch *batch;
+	unsigned int nr_units = 1, req_size, i;
+	void *reqs;
+
+	if (crypto_skcipher_alg(tfm)->base.cra_flags & CRYPTO_ALG_ASYNC)
+		nr_units = BLK_CRYPTO_FALLBACK_MAX_INFLIGHT;
+	req_size = ALIGN(sizeof(struct skcipher_request) +
+			 crypto_skcipher_reqsize(tfm), CRYPTO_MINALIGN);
+
+	/*
+	 * Keep the batch within a single page so that writeback doesn't need
+	 * a higher order allocation, and if even that fails fall back to a
+	 * single request, which is no worse than a plain skcipher_request.
+	 */
+	while (nr_units > 1 &&
+	       blk_crypto_fallback_batch_size(nr_units, req_size) > PAGE_SIZE)
+		nr_units--;
+	batch = kmalloc(blk_crypto_fallback_batch_size(nr_units, req_size),
+			GFP_NOIO | (nr_units > 1 ? __GFP_NOWARN : 0));
+	if (!batch && nr_units > 1) {
+		nr_units = 1;
+		batch = kmalloc(blk_crypto_fallback_batch_size(nr_units,
+							       req_size),
+				GFP_NOIO);
+	}
+	if (!batch)
+		return NULL;
+
+	batch->encrypt = encrypt;
+	batch->nr_units = nr_units;
+	batch->nr_queued = 0;
+	atomic_set(&batch->pending, 1);
+	batch->err = 0;
+	init_completion(&batch->done);
+
+	reqs = (void *)batch + ALIGN(struct_size(batch, units, nr_units),
+				     CRYPTO_MINALIGN);
+	for (i = 0; i < nr_units; i++) {
+		struct blk_crypto_fallback_unit *unit = &batch->units[i];
+
+		unit->req = reqs + i * req_size;
+		skcipher_request_set_tfm(unit->req, tfm);
+		skcipher_request_set_callback(unit->req,
+					      CRYPTO_TFM_REQ_MAY_BACKLOG |
+					      CRYPTO_TFM_REQ_MAY_SLEEP,
+					      blk_crypto_fallback_req_done, batch);
+		sg_init_table(&unit->src, 1);
+		sg_init_table(&unit->dst, 1);
+	}
+	return batch;
+}
+
+/*
+ * Wait for all data units submitted so far and return the first error any of
+ * them saw.
+ */
+static int
+blk_crypto_fallback_flush_batch(struct blk_crypto_fallback_batch *batch)
+{
+	if (batch->nr_queued) {
+		if (!atomic_dec_and_test(&batch->pending))
+			wait_for_completion(&batch->done);
+		atomic_set(&batch->pending, 1);
+		reinit_completion(&batch->done);
+		batch->nr_queued = 0;
+	}
+	return batch->err;
+}
+
+static void
+blk_crypto_fallback_free_batch(struct blk_crypto_fallback_batch *batch)
+{
+	blk_crypto_fallback_flush_batch(batch);
+	kfree_sensitive(batch);
+}
+
+/*
+ * Submit one data unit for en/decryption, waiting for the whole batch once it
+ * is full.  @src_page and @dst_page may be the same page for in-place
+ * decryption.
+ */
+static int
+blk_crypto_fallback_queue_unit(struct blk_crypto_fallback_batch *batch,
+			       struct page *src_page, struct page *dst_page,
+			       unsigned int offset, unsigned int len,
+			       const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE])
+{
+	struct blk_crypto_fallback_unit *unit = &batch->units[batch->nr_queued];
+	struct scatterlist *dst = &unit->src;
+	int err;
+
+	sg_set_page(&unit->src, src_page, len, offset);
+	if (dst_page != src_page) {
+		sg_set_page(&unit->dst, dst_page, len, offset);
+		dst = &unit->dst;
+	}
+	blk_crypto_dun_to_iv(dun, &unit->iv);
+	skcipher_request_set_crypt(unit->req, &unit->src, dst, len,
+				   unit->iv.bytes);
+
+	atomic_inc(&batch->pending);
+	batch->nr_queued++;
+	if (batch->encrypt)
+		err = crypto_skcipher_encrypt(unit->req);
+	else
+		err = crypto_skcipher_decrypt(unit->req);
+	if (err != -EINPROGRESS && err != -EBUSY)
+		blk_crypto_fallback_unit_done(batch, err);
+
+	if (batch->nr_queued == batch->nr_units)
+		return blk_crypto_fallback_flush_batch(batch);
+	return READ_ONCE(batch->err);
+}
+
 /*
  * The crypto API fallback's encryption routine.
  * Allocate a bounce bio for encryption, encrypt the input bio using crypto API,
@@ -264,11 +419,8 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 	struct bio_crypt_ctx *bc;
 	struct blk_crypto_keyslot *slot;
 	int data_unit_size;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
+	struct blk_crypto_fallback_batch *batch;
 	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	struct scatterlist src, dst;
-	union blk_crypto_iv iv;
 	unsigned int i, j;
 	bool ret = false;
 	blk_status_t blk_st;
@@ -299,18 +451,14 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 		goto out_put_enc_bio;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
+	/* and then allocate the skcipher_requests for it */
+	batch = blk_crypto_fallback_alloc_batch(slot, true);
+	if (!batch) {
 		src_bio->bi_status = BLK_STS_RESOURCE;
 		goto out_release_keyslot;
 	}
 
 	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&src, 1);
-	sg_init_table(&dst, 1);
-
-	skcipher_request_set_crypt(ciph_req, &src, &dst, data_unit_size,
-				   iv.bytes);
 
 	/* Encrypt each page in the bounce bio */
 	for (i = 0; i < enc_bio->bi_vcnt; i++) {
@@ -326,40 +474,41 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 			goto out_free_bounce_pages;
 		}
 
-		sg_set_page(&src, plaintext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-		sg_set_page(&dst, ciphertext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-
 		/* Encrypt each data unit in this page */
 		for (j = 0; j < enc_bvec->bv_len; j += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_encrypt(ciph_req),
-					    &wait)) {
+			if (blk_crypto_fallback_queue_unit(batch,
+					plaintext_page, ciphertext_page,
+					enc_bvec->bv_offset + j,
+					data_unit_size, curr_dun)) {
 				i++;
 				src_bio->bi_status = BLK_STS_IOERR;
 				goto out_free_bounce_pages;
 			}
 			bio_crypt_dun_increment(curr_dun, 1);
-			src.offset += data_unit_size;
-			dst.offset += data_unit_size;
 		}
 	}
 
+	if (blk_crypto_fallback_flush_batch(batch)) {
+		src_bio->bi_status = BLK_STS_IOERR;
+		goto out_free_bounce_pages;
+	}
+
 	enc_bio->bi_private = src_bio;
 	enc_bio->bi_end_io = blk_crypto_fallback_encrypt_endio;
 	*bio_ptr = enc_bio;
 	ret = true;
 
 	enc_bio = NULL;
-	goto out_free_ciph_req;
+	goto out_free_batch;
 
 out_free_bounce_pages:
+	/* wait for any data units still in flight before freeing their pages */
+	blk_crypto_fallback_flush_batch(batch);
 	while (i > 0)
 		mempool_free(enc_bio->bi_io_vec[--i].bv_page,
 			     blk_crypto_bounce_page_pool);
-out_free_ciph_req:
-	skcipher_request_free(ciph_req);
+out_free_batch:
+	blk_crypto_fallback_free_batch(batch);
 out_release_keyslot:
 	blk_crypto_put_keyslot(slot);
 out_put_enc_bio:
@@ -380,11 +529,8 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 	struct bio *bio = f_ctx->bio;
 	struct bio_crypt_ctx *bc = &f_ctx->crypt_ctx;
 	struct blk_crypto_keyslot *slot;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
+	struct blk_crypto_fallback_batch *batch;
 	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	union blk_crypto_iv iv;
-	struct scatterlist sg;
 	struct bio_vec bv;
 	struct bvec_iter iter;
 	const int data_unit_size = bc->bc_key->crypto_cfg.data_unit_size;
@@ -402,38 +548,36 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 		goto out_no_keyslot;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
+	/* and then allocate the skcipher_requests for it */
+	batch = blk_crypto_fallback_alloc_batch(slot, false);
+	if (!batch) {
 		bio->bi_status = BLK_STS_RESOURCE;
-		goto out;
+		goto out_release_keyslot;
 	}
 
 	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&sg, 1);
-	skcipher_request_set_crypt(ciph_req, &sg, &sg, data_unit_size,
-				   iv.bytes);
 
 	/* Decrypt each segment in the bio */
 	__bio_for_each_segment(bv, bio, iter, f_ctx->crypt_iter) {
 		struct page *page = bv.bv_page;
 
-		sg_set_page(&sg, page, data_unit_size, bv.bv_offset);
-
 		/* Decrypt each data unit in the segment */
 		for (i = 0; i < bv.bv_len; i += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_decrypt(ciph_req),
-					    &wait)) {
+			if (blk_crypto_fallback_queue_unit(batch, page, page,
+					bv.bv_offset + i, data_unit_size,
+					curr_dun)) {
 				bio->bi_status = BLK_STS_IOERR;
 				goto out;
 			}
 			bio_crypt_dun_increment(curr_dun, 1);
-			sg.offset += data_unit_size;
 		}
 	}
 
+	if (blk_crypto_fallback_flush_batch(batch))
+		bio->bi_status = BLK_STS_IOERR;
 out:
-	skcipher_request_free(ciph_req);
+	blk_crypto_fallback_free_batch(batch);
+out_release_keyslot:
 	blk_crypto_put_keyslot(slot);
 out_no_keyslot:
 	mempool_free(f_ctx, bio_fallback_crypt_ctx_pool);
@@ -59,6 +59,7 @@ static int ahci_port_start(struct ata_port *ap);
 static void ahci_port_stop(struct ata_port *ap);
 static enum ata_completion_errors ahci_qc_prep(struct ata_queued_cmd *qc);
 static int ahci_pmp_qc_defer(struct ata_queued_cmd *qc);
+static void ahci_qc_commit(struct ata_port *ap);
 static void ahci_freeze(struct ata_port *ap);
 static void ahci_thaw(struct ata_port *ap);
 static void ahci_set_aggressive_devslp(struct ata_port *ap, bool sleep);
@@ -155,6 +156,7 @@ struct ata_port_operations ahci_ops = {
 	.qc_defer		= ahci_pmp_qc_defer,
 	.qc_prep		= ahci_qc_prep,
 	.qc_issue		= ahci_qc_issue,
+	.qc_commit		= ahci_qc_commit,
 	.qc_fill_rtf		= ahci_qc_fill_rtf,
 
 	.freeze			= ahci_freeze,
@@ -1883,6 +1885,8 @@ static void ahci_handle_port_interrupt(struct ata_port *ap,
 			qc_active = readl(port_mmio + PORT_CMD_ISSUE);
 	}
 
+	/* commands held back by ahci_qc_issue() are still active */
+	qc_active |= pp->qc_pending & ap->qc_active;
 
 	rc = ata_qc_complete_multiple(ap, qc_active);
 
@@ -1985,11 +1989,26 @@ static irqreturn_t ahci_single_level_irq_intr(int irq, void *dev_instance)
 	return IRQ_RETVAL(rc);
 }
 
+/*
+ * Return and forget the NCQ tags held back by ahci_qc_issue().  Only tags
+ * libata still considers active are returned; must be called with ap->lock
+ * held.
+ */
+static u32 ahci_take_qc_pending(struct ata_port *ap)
+{
+	struct ahci_port_priv *pp = ap->private_data;
+	u32 tags = pp->qc_pending & ap->qc_active;
+
+	pp->qc_pending = 0;
+	return tags;
+}
+
 unsigned int ahci_qc_issue(struct ata_queued_cmd *qc)
 {
 	struct ata_port *ap = qc->ap;
 	void __iomem *port_mmio = ahci_port_base(ap);
 	struct ahci_port_priv *pp = ap->private_data;
+	u32 tags = 0;
 
 	/* Keep track of the currently active link.  It will be used
 	 * in completion path to determine whether NCQ phase is in
@@ -1997,8 +2016,24 @@ unsigned int ahci_qc_issue(struct ata_queued_cmd *qc)
 	 */
 	pp->active_link = qc->dev->link;
 
-	if (ata_is_ncq(qc->tf.protocol))
-		writel(1 << qc->hw_tag, port_mmio + PORT_SCR_ACT);
+	if (ata_is_ncq(qc->tf.protocol)) {
+		pp->qc_pending |= 1 << qc->hw_tag;
+
+		/*
+		 * More commands of the same blk-mq batch are on their way,
+		 * hold this one back so the whole batch is handed to the
+		 * HBA with one PxSACT and one PxCI write.  With FBS the
+		 * device may have to be switched between commands.
+		 */
+		if (!pp->fbs_enabled && qc->scsicmd &&
+		    !(qc->scsicmd->flags & SCMD_LAST)) {
+			ahci_sw_activity(qc->dev->link);
+			return 0;
+		}
+
+		tags = ahci_take_qc_pending(ap);
+		writel(tags, port_mmio + PORT_SCR_ACT);
+	}
 
 	if (pp->fbs_enabled && pp->fbs_last_dev != qc->dev->link->pmp) {
 		u32 fbs = readl(port_mmio + PORT_FBS);
@@ -2008,7 +2043,10 @@ unsigned int ahci_qc_issue(struct ata_queued_cmd *qc)
 		pp->fbs_last_dev = qc->dev->link->pmp;
 	}
 
-	writel(1 << qc->hw_tag, port_mmio + PORT_CMD_ISSUE);
+	if (ata_is_ncq(qc->tf.protocol))
+		writel(tags, port_mmio + PORT_CMD_ISSUE);
+	else
+		writel(1 << qc->hw_tag, port_mmio + PORT_CMD_ISSUE);
 
 	ahci_sw_activity(qc->dev->link);
 
@@ -2016,6 +2054,18 @@ unsigned int ahci_qc_issue(struct ata_queued_cmd *qc)
 }
 EXPORT_SYMBOL_GPL(ahci_qc_issue);
 
+static void ahci_qc_commit(struct ata_port *ap)
+{
+	void __iomem *port_mmio = ahci_port_base(ap);
+	u32 tags = ahci_take_qc_pending(ap);
+
+	if (!tags)
+		return;
+
+	writel(tags, port_mmio + PORT_SCR_ACT);
+	writel(tags, port_mmio + PORT_CMD_ISSUE);
+}
+
 static bool ahci_qc_fill_rtf(struct ata_queued_cmd *qc)
 {
 	struct ahci_port_priv *pp = qc->ap->private_data;
@@ -2043,9 +2093,13 @@ static bool ahci_qc_fill_rtf(struct ata_queued_cmd *qc)
 static void ahci_freeze(struct ata_port *ap)
 {
 	void __iomem *port_mmio = ahci_port_base(ap);
+	struct ahci_port_priv *pp = ap->private_data;
 
 	/* turn IRQ off */
 	writel(0, port_mmio + PORT_IRQ_MASK);
+
+	/* EH fails and retries everything in flight, issued or not */
+	pp->qc_pending = 0;
 }
 
 static void ahci_thaw(struct ata_port *ap)
@@ -2068,6 +2122,16 @@ static void ahci_thaw(struct ata_port *ap)
 void ahci_error_handler(struct ata_port *ap)
 {
 	struct ahci_host_priv *hpriv = ap->host->private_data;
+	struct ahci_port_priv *pp = ap->private_data;
+	unsigned long flags;
+
+	/*
+	 * EH fails or retries every command it found active, including the
+	 * ones held back by ahci_qc_issue() that the HBA never saw.
+	 */
+	spin_lock_irqsave(ap->lock, flags);
+	pp->qc_pending = 0;
+	spin_unlock_irqrestore(ap->lock, flags);
 
 	if (!(ap->pflags & ATA_PFLAG_FROZEN)) {
 		/* restart engine */
@@ -4030,6 +4030,8 @@ int ata_scsi_queuecmd(struct Scsi_Host *shost, struct scsi_cmnd *cmd)
 	struct ata_port *ap;
 	struct ata_device *dev;
 	struct scsi_device *scsidev = cmd->device;
+	/* @cmd may be completed and reused once dispatched, sample it first */
+	bool last = cmd->flags & SCMD_LAST;
 	int rc = 0;
 	unsigned long irq_flags;
 
@@ -4045,12 +4047,45 @@ int ata_scsi_queuecmd(struct Scsi_Host *shost, struct scsi_cmnd *cmd)
 		scsi_done(cmd);
 	}
 
+	/*
+	 * The command ending a batch may have been completed or simulated
+	 * without reaching ->qc_issue(), push out whatever the LLD held
+	 * back for it.
+	 */
+	if (last && ap->ops->qc_commit)
+		ap->ops->qc_commit(ap);
+
 	spin_unlock_irqrestore(ap->lock, irq_flags);
 
 	return rc;
 }
 EXPORT_SYMBOL_GPL(ata_scsi_queuecmd);
 
+/**
+ *	ata_scsi_commit_rqs - issue commands held back by the LLD
+ *	@shost: SCSI host of the port
+ *	@hwq: hardware queue index, unused
+ *
+ *	Called by the SCSI midlayer when a batch of commands ends without
+ *	one flagged SCMD_LAST having been queued.
+ *
+ *	LOCKING:
+ *	Acquires host lock (ap->lock).
+ */
+void ata_scsi_commit_rqs(struct Scsi_Host *shost, u16 hwq)
+{
+	struct ata_port *ap = ata_shost_to_port(shost);
+	unsigned long irq_flags;
+
+	if (!ap->ops->qc_commit)
+		return;
+
+	spin_lock_irqsave(ap->lock, irq_flags);
+	ap->ops->qc_commit(ap);
+	spin_unlock_irqrestore(ap->lock, irq_flags);
+}
+EXPORT_SYMBOL_GPL(ata_scsi_commit_rqs);
+
 /**
  *	ata_scsi_simulate - simulate SCSI command on ATA device
  *	@dev: the target device
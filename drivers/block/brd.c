@@ -24,15 +24,20 @@
 #include <linux/slab.h>
 #include <linux/backing-dev.h>
 #include <linux/debugfs.h>
+#include <linux/dax.h>
+#include <linux/pfn_t.h>
+#include <linux/async_tx.h>
 
 #include <linux/uaccess.h>
 
 /*
  * Each block ramdisk device has a radix_tree brd_pages of pages that stores
- * the pages containing the block device's contents. A brd page's ->index is
- * its offset in PAGE_SIZE units. This is similar to, but in no way connected
- * with, the kernel's pagecache or buffer cache (which sit above our block
- * device).
+ * the pages containing the block device's contents, indexed by their offset
+ * in PAGE_SIZE units. This is similar to, but in no way connected with, the
+ * kernel's pagecache or buffer cache (which sit above our block device).
+ *
+ * Don't use the brd page's ->index or ->mapping: with DAX the pages are
+ * mapped directly into files and fs/dax.c uses those fields for them.
  */
 struct brd_device {
 	int			brd_number;
@@ -46,6 +51,9 @@ struct brd_device {
 	spinlock_t		brd_lock;
 	struct radix_tree_root	brd_pages;
 	u64			brd_nr_pages;
+#ifdef CONFIG_BLK_DEV_RAM_DAX
+	struct dax_device	*brd_dax;
+#endif
 };
 
 /*
@@ -72,8 +80,6 @@ static struct page *brd_lookup_page(struct brd_device *brd, sector_t sector)
 	page = radix_tree_lookup(&brd->brd_pages, idx);
 	rcu_read_unlock();
 
-	BUG_ON(page && page->index != idx);
-
 	return page;
 }
 
@@ -95,8 +101,14 @@ static struct page *brd_insert_page(struct brd_device *brd, sector_t sector)
 	/*
 	 * Must use NOIO because we don't want to recurse back into the
 	 * block or filesystem layers from page reclaim.
+	 *
+	 * DAX hands out the kernel address of our pages, so they can't
+	 * come from highmem in that case.
 	 */
-	gfp_flags = GFP_NOIO | __GFP_ZERO | __GFP_HIGHMEM;
+	gfp_flags = GFP_NOIO | __GFP_ZERO;
+#ifndef CONFIG_BLK_DEV_RAM_DAX
+	gfp_flags |= __GFP_HIGHMEM;
+#endif
 	page = alloc_page(gfp_flags);
 	if (!page)
 		return NULL;
@@ -108,12 +120,10 @@ static struct page *brd_insert_page(struct brd_device *brd, sector_t sector)
 
 	spin_lock(&brd->brd_lock);
 	idx = sector >> PAGE_SECTORS_SHIFT;
-	page->index = idx;
 	if (radix_tree_insert(&brd->brd_pages, idx, page)) {
 		__free_page(page);
 		page = radix_tree_lookup(&brd->brd_pages, idx);
 		BUG_ON(!page);
-		BUG_ON(page->index != idx);
 	} else {
 		brd->brd_nr_pages++;
 	}
@@ -128,43 +138,24 @@ static struct page *brd_insert_page(struct brd_device *brd, sector_t sector)
  * Free all backing store pages and radix tree. This must only be called when
  * there are no other users of the device.
  */
-#define FREE_BATCH 16
 static void brd_free_pages(struct brd_device *brd)
 {
-	unsigned long pos = 0;
-	struct page *pages[FREE_BATCH];
-	int nr_pages;
-
-	do {
-		int i;
+	struct radix_tree_iter iter;
+	void __rcu **slot;
 
-		nr_pages = radix_tree_gang_lookup(&brd->brd_pages,
-				(void **)pages, pos, FREE_BATCH);
+	radix_tree_for_each_slot(slot, &brd->brd_pages, &iter, 0) {
+		struct page *page = radix_tree_deref_slot(slot);
 
-		for (i = 0; i < nr_pages; i++) {
-			void *ret;
-
-			BUG_ON(pages[i]->index < pos);
-			pos = pages[i]->index;
-			ret = radix_tree_delete(&brd->brd_pages, pos);
-			BUG_ON(!ret || ret != pages[i]);
-			__free_page(pages[i]);
-		}
-
-		pos++;
+		radix_tree_iter_delete(&brd->brd_pages, &iter, slot);
+		__free_page(page);
 
 		/*
 		 * It takes 3.4 seconds to remove 80GiB ramdisk.
 		 * So, we need cond_resched to avoid stalling the CPU.
 		 */
+		slot = radix_tree_iter_resume(slot, &iter);
 		cond_resched();
-
-		/*
-		 * This assumes radix_tree_gang_lookup always returns as
-		 * many pages as possible. If the radix-tree code changes,
-		 * so will this have to.
-		 */
-	} while (nr_pages == FREE_BATCH);
+	}
 }
 
 /*
@@ -282,14 +273,162 @@ static int brd_do_bvec(struct brd_device *brd, struct page *page,
 	return err;
 }
 
+#ifdef CONFIG_BLK_DEV_RAM_ASYNC_COPY
+static unsigned int dma_copy_min;
+module_param(dma_copy_min, uint, 0644);
+MODULE_PARM_DESC(dma_copy_min, "Offload bio copies of at least this many bytes to a DMA engine (0 = never)");
+
+static bool brd_use_dma_copy(unsigned int len)
+{
+	unsigned int min = READ_ONCE(dma_copy_min);
+
+	return min && len >= min;
+}
+
+/*
+ * Runs once every copy queued for the bio has completed.  The engine wrote
+ * the pages behind the CPU's back, so flush them like brd_do_bvec() does.
+ */
+static void brd_dma_bio_done(void *param)
+{
+	struct bio *bio = param;
+	struct bio_vec bvec;
+	struct bvec_iter iter;
+
+	if (!op_is_write(bio_op(bio))) {
+		bio_for_each_segment(bvec, bio, iter)
+			flush_dcache_page(bvec.bv_page);
+	}
+	bio_endio(bio);
+}
+
+/*
+ * Queue a copy with async_memcpy(), which uses a DMA engine if one is
+ * available and copies synchronously otherwise.  The copies of a bio are
+ * chained through *tx so that brd_dma_bio_finish() can wait for all of them.
+ */
+static void brd_dma_copy(struct dma_async_tx_descriptor **tx,
+			 struct page *dst, unsigned int dst_off,
+			 struct page *src, unsigned int src_off, size_t len)
+{
+	struct async_submit_ctl submit;
+
+	init_async_submit(&submit, 0, *tx, NULL, NULL, NULL);
+	*tx = async_memcpy(dst, src, dst_off, src_off, len, &submit);
+}
+
+/*
+ * Complete @bio from brd_dma_bio_done() once the last copy chained on @tx
+ * is done.  The bio holds an extra remaining count until then.
+ */
+static void brd_dma_bio_finish(struct bio *bio,
+			       struct dma_async_tx_descriptor *tx)
+{
+	struct async_submit_ctl submit;
+
+	bio_inc_remaining(bio);
+	init_async_submit(&submit, ASYNC_TX_ACK, tx, brd_dma_bio_done, bio,
+			  NULL);
+	async_trigger_callback(&submit);
+	async_tx_issue_pending_all();
+}
+
+/*
+ * Like brd_do_bvec, but for a whole multi-page bvec, and queue the copies
+ * rather than doing them.  Holes are still zero filled by the CPU.
+ */
+static int brd_dma_bvec(struct brd_device *brd, struct bio *bio,
+			struct bio_vec *bvec, sector_t sector,
+			struct dma_async_tx_descriptor **tx)
+{
+	unsigned int len = bvec->bv_len, off = bvec->bv_offset;
+	bool write = op_is_write(bio_op(bio));
+	int err;
+
+	while (len) {
+		unsigned int offset = (sector & (PAGE_SECTORS-1)) << SECTOR_SHIFT;
+		unsigned int bv_off = offset_in_page(off);
+		size_t copy = min_t(size_t, len, PAGE_SIZE - offset);
+		struct page *bv_page, *page;
+
+		copy = min_t(size_t, copy, PAGE_SIZE - bv_off);
+		bv_page = nth_page(bvec->bv_page, off >> PAGE_SHIFT);
+		if (write) {
+			err = copy_to_brd_setup(brd, sector, copy);
+			if (err)
+				return err;
+		}
+
+		page = brd_lookup_page(brd, sector);
+		if (write) {
+			BUG_ON(!page);
+			flush_dcache_page(bv_page);
+			brd_dma_copy(tx, page, offset, bv_page, bv_off, copy);
+		} else if (page) {
+			brd_dma_copy(tx, bv_page, bv_off, page, offset, copy);
+		} else {
+			memzero_page(bv_page, bv_off, copy);
+			flush_dcache_page(bv_page);
+		}
+
+		off += copy;
+		sector += copy >> SECTOR_SHIFT;
+		len -= copy;
+	}
+	return 0;
+}
+#else
+static bool brd_use_dma_copy(unsigned int len)
+{
+	return false;
+}
+
+static void brd_dma_bio_finish(struct bio *bio,
+			       struct dma_async_tx_descriptor *tx)
+{
+}
+
+static int brd_dma_bvec(struct brd_device *brd, struct bio *bio,
+			struct bio_vec *bvec, sector_t sector,
+			struct dma_async_tx_descriptor **tx)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
+/*
+ * brd_do_bvec for a multi-page bvec, one page at a time.
+ */
+static int brd_do_mp_bvec(struct brd_device *brd, struct bio_vec *bvec,
+			  enum req_op op, sector_t sector)
+{
+	unsigned int len = bvec->bv_len, off = bvec->bv_offset;
+	int err = 0;
+
+	while (len && !err) {
+		struct page *page = nth_page(bvec->bv_page, off >> PAGE_SHIFT);
+		unsigned int bv_off = offset_in_page(off);
+		unsigned int copy = min_t(unsigned int, len, PAGE_SIZE - bv_off);
+
+		err = brd_do_bvec(brd, page, copy, bv_off, op, sector);
+		off += copy;
+		sector += copy >> SECTOR_SHIFT;
+		len -= copy;
+	}
+	return err;
+}
+
 static void brd_submit_bio(struct bio *bio)
 {
 	struct brd_device *brd = bio->bi_bdev->bd_disk->private_data;
 	sector_t sector = bio->bi_iter.bi_sector;
+	struct dma_async_tx_descriptor *tx = NULL;
 	struct bio_vec bvec;
 	struct bvec_iter iter;
+	bool dma_queued = false;
 
-	bio_for_each_segment(bvec, bio, iter) {
+	/* whole bvecs, so that dma_copy_min can be larger than a page */
+	bio_for_each_bvec(bvec, bio, iter) {
 		unsigned int len = bvec.bv_len;
 		int err;
 
@@ -297,15 +436,22 @@ static void brd_submit_bio(struct bio *bio)
 		WARN_ON_ONCE((bvec.bv_offset & (SECTOR_SIZE - 1)) ||
 				(len & (SECTOR_SIZE - 1)));
 
-		err = brd_do_bvec(brd, bvec.bv_page, len, bvec.bv_offset,
-				  bio_op(bio), sector);
+		if (brd_use_dma_copy(len)) {
+			err = brd_dma_bvec(brd, bio, &bvec, sector, &tx);
+			dma_queued = true;
+		} else {
+			err = brd_do_mp_bvec(brd, &bvec, bio_op(bio), sector);
+		}
 		if (err) {
-			bio_io_error(bio);
-			return;
+			bio->bi_status = BLK_STS_IOERR;
+			break;
 		}
 		sector += len >> SECTOR_SHIFT;
 	}
 
+	/* copies already queued still complete the bio once they are done */
+	if (dma_queued)
+		brd_dma_bio_finish(bio, tx);
 	bio_endio(bio);
 }
 
@@ -328,6 +474,91 @@ static const struct block_device_operations brd_fops = {
 	.rw_page =		brd_rw_page,
 };
 
+#ifdef CONFIG_BLK_DEV_RAM_DAX
+/*
+ * Our pages aren't physically contiguous, so only ever hand out one page at a
+ * time.  That also keeps fs/dax.c from trying PMD mappings, which need devmap
+ * pages we don't have.
+ */
+static long brd_dax_direct_access(struct dax_device *dax_dev,
+		pgoff_t pgoff, long nr_pages, enum dax_access_mode mode,
+		void **kaddr, pfn_t *pfn)
+{
+	struct brd_device *brd = dax_get_private(dax_dev);
+	struct page *page;
+
+	/* don't allocate backing pages past the end of the disk */
+	if (pgoff >= get_capacity(brd->brd_disk) >> PAGE_SECTORS_SHIFT)
+		return -ERANGE;
+
+	page = brd_insert_page(brd, (sector_t)pgoff << PAGE_SECTORS_SHIFT);
+	if (!page)
+		return -ENOSPC;
+	if (kaddr)
+		*kaddr = page_address(page);
+	if (pfn)
+		*pfn = page_to_pfn_t(page);
+	return 1;
+}
+
+static int brd_dax_zero_page_range(struct dax_device *dax_dev, pgoff_t pgoff,
+		size_t nr_pages)
+{
+	struct brd_device *brd = dax_get_private(dax_dev);
+
+	/* pages that were never written already read back as zeroes */
+	for (; nr_pages; nr_pages--, pgoff++) {
+		struct page *page;
+
+		page = brd_lookup_page(brd, (sector_t)pgoff << PAGE_SECTORS_SHIFT);
+		if (page)
+			clear_page(page_address(page));
+	}
+	return 0;
+}
+
+static const struct dax_operations brd_dax_ops = {
+	.direct_access = brd_dax_direct_access,
+	.zero_page_range = brd_dax_zero_page_range,
+};
+
+static int brd_dax_init(struct brd_device *brd)
+{
+	struct dax_device *dax_dev;
+	int err;
+
+	dax_dev = alloc_dax(brd, &brd_dax_ops);
+	if (IS_ERR(dax_dev))
+		return PTR_ERR(dax_dev);
+	set_dax_synchronous(dax_dev);
+	err = dax_add_host(dax_dev, brd->brd_disk);
+	if (err) {
+		kill_dax(dax_dev);
+		put_dax(dax_dev);
+		return err;
+	}
+	brd->brd_dax = dax_dev;
+	blk_queue_flag_set(QUEUE_FLAG_DAX, brd->brd_disk->queue);
+	return 0;
+}
+
+static void brd_dax_exit(struct brd_device *brd)
+{
+	dax_remove_host(brd->brd_disk);
+	kill_dax(brd->brd_dax);
+	put_dax(brd->brd_dax);
+}
+#else
+static inline int brd_dax_init(struct brd_device *brd)
+{
+	return 0;
+}
+
+static inline void brd_dax_exit(struct brd_device *brd)
+{
+}
+#endif /* CONFIG_BLK_DEV_RAM_DAX */
+
 /*
  * And now the modules code and kernel interface.
  */
@@ -412,12 +643,19 @@ static int brd_alloc(int i)
 	/* Tell the block layer that this is not a rotational device */
 	blk_queue_flag_set(QUEUE_FLAG_NONROT, disk->queue);
 	blk_queue_flag_clear(QUEUE_FLAG_ADD_RANDOM, disk->queue);
-	err = add_disk(disk);
+
+	err = brd_dax_init(brd);
 	if (err)
 		goto out_cleanup_disk;
 
+	err = add_disk(disk);
+	if (err)
+		goto out_cleanup_dax;
+
 	return 0;
 
+out_cleanup_dax:
+	brd_dax_exit(brd);
 out_cleanup_disk:
 	put_disk(disk);
 out_free_dev:
@@ -438,6 +676,7 @@ static void brd_cleanup(void)
 	debugfs_remove_recursive(brd_debugfs_dir);
 
 	list_for_each_entry_safe(brd, next, &brd_devices, brd_list) {
+		brd_dax_exit(brd);
 		del_gendisk(brd->brd_disk);
 		put_disk(brd->brd_disk);
 		brd_free_pages(brd);
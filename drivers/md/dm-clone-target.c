@@ -97,8 +97,9 @@ struct clone {
 	unsigned long last_commit_jiffies;
 
 	/*
-	 * We defer incoming WRITE bios for regions that are not hydrated,
-	 * until after these regions have been hydrated.
+	 * We defer incoming WRITE bios, and READ bios with hydrate_on_read,
+	 * for regions that are not hydrated, until after these regions have
+	 * been hydrated.
 	 *
 	 * Also, we defer REQ_FUA and REQ_PREFLUSH bios, until after the
 	 * metadata have been committed.
@@ -143,6 +144,7 @@ struct clone {
 #define DM_CLONE_DISCARD_PASSDOWN 0
 #define DM_CLONE_HYDRATION_ENABLED 1
 #define DM_CLONE_HYDRATION_SUSPENDED 2
+#define DM_CLONE_HYDRATE_ON_READ 3
 
 /*---------------------------------------------------------------------------*/
 
@@ -1354,16 +1356,18 @@ static int clone_map(struct dm_target *ti, struct bio *bio)
 	 * device.
 	 *
 	 * If the region is not hydrated and the bio is a READ, redirect it to
-	 * the source device.
+	 * the source device, unless we were asked to hydrate on read.
 	 *
-	 * Else, defer WRITE bio until after its region has been hydrated and
+	 * Else, defer the bio until after its region has been hydrated and
 	 * start the region's hydration immediately.
 	 */
 	region_nr = bio_to_region(clone, bio);
 	if (dm_clone_is_region_hydrated(clone->cmd, region_nr)) {
 		remap_and_issue(clone, bio);
 		return DM_MAPIO_SUBMITTED;
-	} else if (bio_data_dir(bio) == READ) {
+	} else if (bio_data_dir(bio) == READ &&
+		   (!test_bit(DM_CLONE_HYDRATE_ON_READ, &clone->flags) ||
+		    get_clone_mode(clone) >= CM_READ_ONLY)) {
 		remap_to_source(clone, bio);
 		return DM_MAPIO_REMAPPED;
 	}
@@ -1391,6 +1395,7 @@ static void emit_flags(struct clone *clone, char *result, unsigned int maxlen,
 
 	count = !test_bit(DM_CLONE_HYDRATION_ENABLED, &clone->flags);
 	count += !test_bit(DM_CLONE_DISCARD_PASSDOWN, &clone->flags);
+	count += test_bit(DM_CLONE_HYDRATE_ON_READ, &clone->flags);
 
 	DMEMIT("%u ", count);
 
@@ -1400,6 +1405,9 @@ static void emit_flags(struct clone *clone, char *result, unsigned int maxlen,
 	if (!test_bit(DM_CLONE_DISCARD_PASSDOWN, &clone->flags))
 		DMEMIT("no_discard_passdown ");
 
+	if (test_bit(DM_CLONE_HYDRATE_ON_READ, &clone->flags))
+		DMEMIT("hydrate_on_read ");
+
 	*sz_ptr = sz;
 }
 
@@ -1532,7 +1540,7 @@ static sector_t get_dev_size(struct dm_dev *dev)
  * region size: dm-clone unit size in sectors
  *
  * #feature args: Number of feature arguments passed
- * feature args: E.g. no_hydration, no_discard_passdown
+ * feature args: E.g. no_hydration, no_discard_passdown, hydrate_on_read
  *
  * #core arguments: An even number of core arguments
  * core arguments: Key/value pairs for tuning the core
@@ -1547,7 +1555,7 @@ static int parse_feature_args(struct dm_arg_set *as, struct clone *clone)
 
 	const struct dm_arg args = {
 		.min = 0,
-		.max = 2,
+		.max = 3,
 		.error = "Invalid number of feature arguments"
 	};
 
@@ -1567,6 +1575,8 @@ static int parse_feature_args(struct dm_arg_set *as, struct clone *clone)
 			__clear_bit(DM_CLONE_HYDRATION_ENABLED, &clone->flags);
 		} else if (!strcasecmp(arg_name, "no_discard_passdown")) {
 			__clear_bit(DM_CLONE_DISCARD_PASSDOWN, &clone->flags);
+		} else if (!strcasecmp(arg_name, "hydrate_on_read")) {
+			__set_bit(DM_CLONE_HYDRATE_ON_READ, &clone->flags);
 		} else {
 			ti->error = "Invalid feature argument";
 			return -EINVAL;
@@ -2176,7 +2186,7 @@ static int clone_message(struct dm_target *ti, unsigned int argc, char **argv,
 
 static struct target_type clone_target = {
 	.name = "clone",
-	.version = {1, 0, 0},
+	.version = {1, 1, 0},
 	.module = THIS_MODULE,
 	.ctr = clone_ctr,
 	.dtr =  clone_dtr,
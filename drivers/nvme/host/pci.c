@@ -2836,10 +2836,13 @@ static void nvme_reset_work(struct work_struct *work)
 
 	/*
 	 * Limit the max command size to prevent iod->sg allocations going
-	 * over a single page.
+	 * over a single page.  Also keep it within the optimal DMA mapping
+	 * size, so that with an IOMMU every command's IOVA is recycled
+	 * through the per-CPU IOVA caches instead of falling back to the
+	 * much slower rbtree allocator.
 	 */
 	dev->ctrl.max_hw_sectors = min_t(u32,
-		NVME_MAX_KB_SZ << 1, dma_max_mapping_size(dev->dev) >> 9);
+		NVME_MAX_KB_SZ << 1, dma_opt_mapping_size(dev->dev) >> 9);
 	dev->ctrl.max_segments = NVME_MAX_SEGS;
 
 	/*
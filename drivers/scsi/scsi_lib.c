@@ -1295,6 +1295,15 @@ static inline int scsi_target_queue_ready(struct Scsi_Host *shost,
 	if (starget->can_queue <= 0)
 		return 1;
 
+	/*
+	 * A saturated target is polled by every LUN behind it on each
+	 * dispatch attempt, so check the count before dirtying the shared
+	 * cacheline with an increment we would undo right away.
+	 */
+	if (atomic_read(&starget->target_busy) >= starget->can_queue &&
+	    !atomic_read(&starget->target_blocked))
+		goto starved_nodec;
+
 	busy = atomic_inc_return(&starget->target_busy) - 1;
 	if (atomic_read(&starget->target_blocked) > 0) {
 		if (busy)
@@ -1316,12 +1325,15 @@ static inline int scsi_target_queue_ready(struct Scsi_Host *shost,
 	return 1;
 
 starved:
+	atomic_dec(&starget->target_busy);
+starved_nodec:
 	spin_lock_irq(shost->host_lock);
 	list_move_tail(&sdev->starved_entry, &shost->starved_list);
 	spin_unlock_irq(shost->host_lock);
+	return 0;
+
 out_dec:
-	if (starget->can_queue > 0)
-		atomic_dec(&starget->target_busy);
+	atomic_dec(&starget->target_busy);
 	return 0;
 }
 
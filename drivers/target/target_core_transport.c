@@ -874,6 +874,7 @@ void target_complete_cmd_with_sense(struct se_cmd *cmd, u8 scsi_status,
 				    sense_reason_t sense_reason)
 {
 	struct se_wwn *wwn = cmd->se_sess->se_tpg->se_tpg_wwn;
+	struct se_cmd_queue *cq;
 	int success, cpu;
 	unsigned long flags;
 
@@ -908,10 +909,39 @@ void target_complete_cmd_with_sense(struct se_cmd *cmd, u8 scsi_status,
 	else
 		cpu = wwn->cmd_compl_affinity;
 
-	queue_work_on(cpu, target_completion_wq, &cmd->work);
+	if (!cmd->se_dev) {
+		queue_work_on(cpu, target_completion_wq, &cmd->work);
+		return;
+	}
+
+	/*
+	 * Backends complete from bio end_io, so a burst of completions on a
+	 * CPU is handed to the fabric by a single work item rather than one
+	 * workqueue hop per command.
+	 */
+	cq = &cmd->se_dev->queues[cpu].cq;
+	if (llist_add(&cmd->se_cmd_compl_list, &cq->cmd_list))
+		queue_work_on(cpu, target_completion_wq, &cq->work);
 }
 EXPORT_SYMBOL(target_complete_cmd_with_sense);
 
+void target_queued_compl_work(struct work_struct *work)
+{
+	struct se_cmd_queue *cq = container_of(work, struct se_cmd_queue, work);
+	struct se_cmd *se_cmd, *next_cmd;
+	struct llist_node *cmd_list;
+
+	cmd_list = llist_del_all(&cq->cmd_list);
+	if (!cmd_list)
+		return;
+
+	cmd_list = llist_reverse_order(cmd_list);
+	/* run the work set up by target_complete_cmd_with_sense() */
+	llist_for_each_entry_safe(se_cmd, next_cmd, cmd_list,
+				  se_cmd_compl_list)
+		se_cmd->work.func(&se_cmd->work);
+}
+
 void target_complete_cmd(struct se_cmd *cmd, u8 scsi_status)
 {
 	target_complete_cmd_with_sense(cmd, scsi_status, scsi_status ?
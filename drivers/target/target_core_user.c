@@ -660,6 +660,14 @@ static inline void tcmu_flush_dcache_range(void *vaddr, size_t size)
 	unsigned long offset = offset_in_page(vaddr);
 	void *start = vaddr - offset;
 
+	/*
+	 * The ring is flushed several times per command; don't walk the
+	 * vmalloc page tables for nothing on architectures that leave
+	 * flush_dcache_page() empty (e.g. x86).
+	 */
+	if (!ARCH_IMPLEMENTS_FLUSH_DCACHE_PAGE)
+		return;
+
 	size = round_up(size+offset, PAGE_SIZE);
 
 	while (size) {
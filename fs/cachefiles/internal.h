@@ -16,10 +16,18 @@
 #include <linux/cred.h>
 #include <linux/security.h>
 #include <linux/xarray.h>
+#include <linux/sizes.h>
 #include <linux/cachefiles.h>
 
 #define CACHEFILES_DIO_BLOCK_SIZE 4096
 
+/*
+ * On-demand read requests sent to the daemon are extended up to the next
+ * multiple of this size, short of any data already in the cache, so that one
+ * round trip also fetches what follows a miss.
+ */
+#define CACHEFILES_ONDEMAND_READ_GRANULE SZ_1M
+
 struct cachefiles_cache;
 struct cachefiles_object;
 
@@ -486,8 +486,20 @@ static enum netfs_io_source cachefiles_prepare_read(struct netfs_io_subrequest *
 download_and_store:
 	__set_bit(NETFS_SREQ_COPY_TO_CACHE, &subreq->flags);
 	if (test_bit(NETFS_SREQ_ONDEMAND, &subreq->flags)) {
+		/*
+		 * Ask the daemon for the rest of the granule too, so that
+		 * adjacent misses are satisfied from the cache rather than
+		 * each costing another round trip.  Start at the miss, which
+		 * is the first uncached byte, and stop at the next cached data
+		 * found by SEEK_DATA above so that nothing is fetched twice.
+		 */
+		to = round_up(subreq->start + subreq->len,
+			      CACHEFILES_ONDEMAND_READ_GRANULE);
+		to = min_t(loff_t, to, round_up(i_size, cache->bsize));
+		if (off > subreq->start)
+			to = min(to, off);
 		rc = cachefiles_ondemand_read(object, subreq->start,
-					      subreq->len);
+					      to - subreq->start);
 		if (!rc) {
 			__clear_bit(NETFS_SREQ_ONDEMAND, &subreq->flags);
 			goto retry;
@@ -132,7 +132,7 @@ struct dio {
 	bool defer_completion;		/* defer AIO completion to workqueue? */
 	bool should_dirty;		/* if pages should be dirtied */
 	int io_error;			/* IO error in completion path */
-	unsigned long refcount;		/* direct_io_worker() and bios */
+	atomic_t refcount;		/* direct_io_worker() and bios */
 	struct bio *bio_list;		/* singly linked via bi_private */
 	struct task_struct *waiter;	/* waiting task (NULL if none) */
 
@@ -330,18 +330,29 @@ static void dio_bio_end_aio(struct bio *bio)
 {
 	struct dio *dio = bio->bi_private;
 	const enum req_op dio_op = dio->opf & REQ_OP_MASK;
-	unsigned long remaining;
 	unsigned long flags;
+	int remaining;
 	bool defer_completion = false;
 
 	/* cleanup the bio */
 	dio_bio_complete(dio, bio);
 
-	spin_lock_irqsave(&dio->bio_lock, flags);
-	remaining = --dio->refcount;
-	if (remaining == 1 && dio->waiter)
-		wake_up_process(dio->waiter);
-	spin_unlock_irqrestore(&dio->bio_lock, flags);
+	/*
+	 * The waiter in dio_await_one() tests the count under the bio_lock and
+	 * may return without sleeping once it drops to one, after which the
+	 * submitter can free the dio.  So only the drop to one is done, and the
+	 * waiter woken, while holding the lock; every other drop can't be seen
+	 * by a waiter and needs no lock.
+	 */
+	remaining = atomic_fetch_add_unless(&dio->refcount, -1, 2) - 1;
+	if (remaining == 1) {
+		/* not dropped yet, that's left for under the lock */
+		spin_lock_irqsave(&dio->bio_lock, flags);
+		remaining = atomic_dec_return(&dio->refcount);
+		if (remaining == 1 && dio->waiter)
+			wake_up_process(dio->waiter);
+		spin_unlock_irqrestore(&dio->bio_lock, flags);
+	}
 
 	if (remaining == 0) {
 		/*
@@ -381,7 +392,7 @@ static void dio_bio_end_io(struct bio *bio)
 	spin_lock_irqsave(&dio->bio_lock, flags);
 	bio->bi_private = dio->bio_list;
 	dio->bio_list = bio;
-	if (--dio->refcount == 1 && dio->waiter)
+	if (atomic_dec_return(&dio->refcount) == 1 && dio->waiter)
 		wake_up_process(dio->waiter);
 	spin_unlock_irqrestore(&dio->bio_lock, flags);
 }
@@ -418,15 +429,12 @@ static inline void dio_bio_submit(struct dio *dio, struct dio_submit *sdio)
 {
 	const enum req_op dio_op = dio->opf & REQ_OP_MASK;
 	struct bio *bio = sdio->bio;
-	unsigned long flags;
 
 	bio->bi_private = dio;
 	/* don't account direct I/O as memory stall */
 	bio_clear_flag(bio, BIO_WORKINGSET);
 
-	spin_lock_irqsave(&dio->bio_lock, flags);
-	dio->refcount++;
-	spin_unlock_irqrestore(&dio->bio_lock, flags);
+	atomic_inc(&dio->refcount);
 
 	if (dio->is_async && dio_op == REQ_OP_READ && dio->should_dirty)
 		bio_set_pages_dirty(bio);
@@ -471,7 +479,7 @@ static struct bio *dio_await_one(struct dio *dio)
 	 * holding the bio_lock so we don't need set_current_state()'s barrier
 	 * and can call it after testing our condition.
 	 */
-	while (dio->refcount > 1 && dio->bio_list == NULL) {
+	while (atomic_read(&dio->refcount) > 1 && dio->bio_list == NULL) {
 		__set_current_state(TASK_UNINTERRUPTIBLE);
 		dio->waiter = current;
 		spin_unlock_irqrestore(&dio->bio_lock, flags);
@@ -1076,24 +1084,14 @@ static int do_direct_IO(struct dio *dio, struct dio_submit *sdio,
 
 static inline int drop_refcount(struct dio *dio)
 {
-	int ret2;
-	unsigned long flags;
-
 	/*
 	 * Sync will always be dropping the final ref and completing the
 	 * operation.  AIO can if it was a broken operation described above or
 	 * in fact if all the bios race to complete before we get here.  In
 	 * that case dio_complete() translates the EIOCBQUEUED into the proper
 	 * return code that the caller will hand to ->complete().
-	 *
-	 * This is managed by the bio_lock instead of being an atomic_t so that
-	 * completion paths can drop their ref and use the remaining count to
-	 * decide to wake the submission path atomically.
 	 */
-	spin_lock_irqsave(&dio->bio_lock, flags);
-	ret2 = --dio->refcount;
-	spin_unlock_irqrestore(&dio->bio_lock, flags);
-	return ret2;
+	return atomic_dec_return(&dio->refcount);
 }
 
 /*
@@ -1248,7 +1246,7 @@ ssize_t __blockdev_direct_IO(struct kiocb *iocb, struct inode *inode,
 	dio->iocb = iocb;
 
 	spin_lock_init(&dio->bio_lock);
-	dio->refcount = 1;
+	atomic_set(&dio->refcount, 1);
 
 	dio->should_dirty = user_backed_iter(iter) && iov_iter_rw(iter) == READ;
 	sdio.iter = iter;
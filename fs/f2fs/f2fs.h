@@ -4361,6 +4361,20 @@ F2FS_FEATURE_FUNCS(casefold, CASEFOLD);
 F2FS_FEATURE_FUNCS(compression, COMPRESSION);
 F2FS_FEATURE_FUNCS(readonly, RO);
 
+/*
+ * Data blocks of these inodes are migrated by GC through META_MAPPING
+ * (move_data_block) rather than through the inode's page cache.  On zoned
+ * devices this lets GC move LBAs directly without instantiating and dirtying
+ * data pages in the page cache of every victim inode.  Readers of the
+ * zoned-only inodes wait for those copies only while META_MAPPING has pages
+ * under writeback, see f2fs_wait_on_block_writeback().
+ */
+static inline bool f2fs_meta_inode_gc_required(struct inode *inode)
+{
+	return f2fs_post_read_required(inode) ||
+		f2fs_sb_has_blkzoned(F2FS_I_SB(inode));
+}
+
 static inline bool f2fs_may_extent_tree(struct inode *inode)
 {
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
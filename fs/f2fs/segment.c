@@ -3603,12 +3603,27 @@ void f2fs_wait_on_page_writeback(struct page *page,
 	}
 }
 
+/*
+ * On zoned devices GC also migrates blocks of plain inodes through
+ * META_MAPPING, and publishes the new address before the write completes.
+ * Those are the only META_MAPPING copies of such inodes, so they need a
+ * lookup only while something in META_MAPPING is under writeback.
+ */
+static bool need_block_writeback_wait(struct inode *inode)
+{
+	if (f2fs_post_read_required(inode))
+		return true;
+	return f2fs_meta_inode_gc_required(inode) &&
+		mapping_tagged(META_MAPPING(F2FS_I_SB(inode)),
+			       PAGECACHE_TAG_WRITEBACK);
+}
+
 void f2fs_wait_on_block_writeback(struct inode *inode, block_t blkaddr)
 {
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
 	struct page *cpage;
 
-	if (!f2fs_post_read_required(inode))
+	if (!need_block_writeback_wait(inode))
 		return;
 
 	if (!__is_valid_data_blkaddr(blkaddr))
@@ -3627,13 +3642,15 @@ void f2fs_wait_on_block_writeback_range(struct inode *inode, block_t blkaddr,
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
 	block_t i;
 
-	if (!f2fs_post_read_required(inode))
+	if (!need_block_writeback_wait(inode))
 		return;
 
 	for (i = 0; i < len; i++)
 		f2fs_wait_on_block_writeback(inode, blkaddr + i);
 
-	invalidate_mapping_pages(META_MAPPING(sbi), blkaddr, blkaddr + len - 1);
+	if (f2fs_post_read_required(inode))
+		invalidate_mapping_pages(META_MAPPING(sbi), blkaddr,
+					 blkaddr + len - 1);
 }
 
 static int read_compacted_summaries(struct f2fs_sb_info *sbi)
@@ -771,15 +771,25 @@ static long do_splice_to(struct file *in, loff_t *ppos,
 			 struct pipe_inode_info *pipe, size_t len,
 			 unsigned int flags)
 {
-	unsigned int p_space;
+	unsigned int p_space, buf_shift = PAGE_SHIFT;
 	int ret;
 
 	if (unlikely(!(in->f_mode & FMODE_READ)))
 		return -EBADF;
 
-	/* Don't try to read more the pipe has space for. */
+	/*
+	 * Don't try to read more the pipe has space for.  Page cache reads
+	 * emit one pipe buffer per folio rather than per page, so a mapping
+	 * with large folios can fill each free slot with more than a page.
+	 * If the folios turn out to be smaller, buffered ->splice_read()
+	 * simply stops short when the pipe is full.  Direct I/O still needs
+	 * one page per slot, so keep the exact limit there.
+	 */
+	if (!(in->f_flags & O_DIRECT) && in->f_mapping &&
+	    mapping_large_folio_support(in->f_mapping))
+		buf_shift += MAX_PAGECACHE_ORDER;
 	p_space = pipe->max_usage - pipe_occupancy(pipe->head, pipe->tail);
-	len = min_t(size_t, len, p_space << PAGE_SHIFT);
+	len = min_t(size_t, len, (size_t)p_space << buf_shift);
 
 	ret = rw_verify_area(READ, in, ppos, len);
 	if (unlikely(ret < 0))
@@ -2929,10 +2929,14 @@ xlog_state_get_iclog_space(
 
 	iclog = log->l_iclog;
 	if (iclog->ic_state != XLOG_STATE_ACTIVE) {
+		u64	wait_start = ktime_get_ns();
+
 		XFS_STATS_INC(log->l_mp, xs_log_noiclogs);
 
 		/* Wait for log writes to have flushed */
 		xlog_wait(&log->l_flush_wait, &log->l_icloglock);
+		XFS_STATS_ADD(log->l_mp, xs_iclog_wait_ns,
+				ktime_get_ns() - wait_start);
 		goto restart;
 	}
 
@@ -1190,6 +1190,7 @@ xlog_cil_push_work(
 	bool			push_commit_stable;
 	LIST_HEAD		(whiteouts);
 	struct xlog_ticket	*ticket;
+	u64			push_start = ktime_get_ns();
 
 	new_ctx = xlog_cil_ctx_alloc();
 	new_ctx->ticket = xlog_cil_ticket_alloc(log);
@@ -1351,12 +1352,16 @@ xlog_cil_push_work(
 
 		plsn = be64_to_cpu(ctx->commit_iclog->ic_prev->ic_header.h_lsn);
 		if (plsn && XFS_LSN_CMP(plsn, ctx->commit_lsn) < 0) {
+			u64	wait_start = ktime_get_ns();
+
 			/*
 			 * Waiting on ic_force_wait orders the completion of
 			 * iclogs older than ic_prev. Hence we only need to wait
 			 * on the most recent older iclog here.
 			 */
 			xlog_wait_on_iclog(ctx->commit_iclog->ic_prev);
+			XFS_STATS_ADD(log->l_mp, xs_iclog_wait_ns,
+					ktime_get_ns() - wait_start);
 			spin_lock(&log->l_icloglock);
 		}
 
@@ -1389,6 +1394,15 @@ xlog_cil_push_work(
 	spin_unlock(&log->l_icloglock);
 	xlog_cil_cleanup_whiteouts(&whiteouts);
 	xfs_log_ticket_ungrant(log, ticket);
+
+	/*
+	 * Account the time from picking up the push to handing the commit
+	 * iclog to the log. Along with the iclog wait time accumulated in
+	 * xlog_state_get_iclog_space(), this tells us whether checkpoint
+	 * formatting or iclog availability is limiting push throughput.
+	 */
+	XFS_STATS_INC(log->l_mp, xs_cil_pushes);
+	XFS_STATS_ADD(log->l_mp, xs_cil_push_ns, ktime_get_ns() - push_start);
 	return;
 
 out_skip:
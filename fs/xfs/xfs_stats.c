@@ -24,6 +24,9 @@ int xfs_stats_format(struct xfsstats __percpu *stats, char *buf)
 	uint64_t	xs_write_bytes = 0;
 	uint64_t	xs_read_bytes = 0;
 	uint64_t	defer_relog = 0;
+	uint64_t	xs_cil_pushes = 0;
+	uint64_t	xs_cil_push_ns = 0;
+	uint64_t	xs_iclog_wait_ns = 0;
 
 	static const struct xstats_entry {
 		char	*desc;
@@ -72,12 +75,17 @@ int xfs_stats_format(struct xfsstats __percpu *stats, char *buf)
 		xs_write_bytes += per_cpu_ptr(stats, i)->s.xs_write_bytes;
 		xs_read_bytes += per_cpu_ptr(stats, i)->s.xs_read_bytes;
 		defer_relog += per_cpu_ptr(stats, i)->s.defer_relog;
+		xs_cil_pushes += per_cpu_ptr(stats, i)->s.xs_cil_pushes;
+		xs_cil_push_ns += per_cpu_ptr(stats, i)->s.xs_cil_push_ns;
+		xs_iclog_wait_ns += per_cpu_ptr(stats, i)->s.xs_iclog_wait_ns;
 	}
 
 	len += scnprintf(buf + len, PATH_MAX-len, "xpc %Lu %Lu %Lu\n",
 			xs_xstrat_bytes, xs_write_bytes, xs_read_bytes);
 	len += scnprintf(buf + len, PATH_MAX-len, "defer_relog %llu\n",
 			defer_relog);
+	len += scnprintf(buf + len, PATH_MAX-len, "cil_push %llu %llu %llu\n",
+			xs_cil_pushes, xs_cil_push_ns, xs_iclog_wait_ns);
 	len += scnprintf(buf + len, PATH_MAX-len, "debug %u\n",
 #if defined(DEBUG)
 		1);
@@ -138,6 +138,9 @@ struct __xfsstats {
 	uint64_t		xs_write_bytes;
 	uint64_t		xs_read_bytes;
 	uint64_t		defer_relog;
+	uint64_t		xs_cil_pushes;
+	uint64_t		xs_cil_push_ns;
+	uint64_t		xs_iclog_wait_ns;
 };
 
 #define	xfsstats_offset(f)	(offsetof(struct __xfsstats, f)/sizeof(uint32_t))
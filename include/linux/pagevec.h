@@ -11,8 +11,13 @@
 
 #include <linux/xarray.h>
 
-/* 15 pointers + header align the pagevec structure to a power of two */
-#define PAGEVEC_SIZE	15
+/*
+ * 31 pointers + header align the pagevec structure to a power of two.
+ * Batched page cache lookups such as filemap_get_read_batch() fill one
+ * pagevec per XArray walk, so a larger batch means fewer walks, fewer
+ * readahead checks and fewer release passes per large read.
+ */
+#define PAGEVEC_SIZE	31
 
 struct page;
 struct folio;
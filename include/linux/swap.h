@@ -32,7 +32,13 @@ struct pagevec;
 #define SWAP_FLAGS_VALID	(SWAP_FLAG_PRIO_MASK | SWAP_FLAG_PREFER | \
 				 SWAP_FLAG_DISCARD | SWAP_FLAG_DISCARD_ONCE | \
 				 SWAP_FLAG_DISCARD_PAGES)
-#define SWAP_BATCH 64
+/*
+ * Number of slots handed out or returned per swap_info_struct lock hold by
+ * the per-cpu slot caches.  Without CONFIG_THP_SWAP this is SWAPFILE_CLUSTER,
+ * so a refill typically claims a whole cluster; with it a cluster is
+ * HPAGE_PMD_NR slots (512 on x86-64) and a refill takes part of one.
+ */
+#define SWAP_BATCH 256
 
 static inline int current_is_kswapd(void)
 {
@@ -133,9 +133,14 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		VMACACHE_FIND_CALLS,
 		VMACACHE_FIND_HITS,
 #endif
+		RA_CGROUP_TRIMMED,
 #ifdef CONFIG_SWAP
 		SWAP_RA,
 		SWAP_RA_HIT,
+		SWAP_SLOT_ALLOC,
+		SWAP_SLOT_ALLOC_LOCK,
+		SWAP_SLOT_FREE,
+		SWAP_SLOT_FREE_LOCK,
 #ifdef CONFIG_KSM
 		KSM_SWPIN_COPY,
 #endif
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Test cases and microbenchmark for the library CRC functions.
+ *
+ * crc_t10dif(), crc64_rocksoft() and crc32c() dispatch to whatever
+ * accelerated implementation is registered with the crypto API.  Check them
+ * against the library table code and report throughput per buffer size, so
+ * that a regression in either the dispatch or the arch code shows up.
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <kunit/test.h>
+#include <linux/crc-t10dif.h>
+#include <linux/crc32.h>
+#include <linux/crc32c.h>
+#include <linux/crc64.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+
+#define CRC_TEST_BUF_LEN	65536
+#define CRC_TEST_ITERS		1000
+#define CRC_BENCH_BYTES		(8 * 1024 * 1024)
+
+struct crc_variant {
+	const char *name;
+	u64 (*func)(u64 crc, const u8 *p, size_t len);
+	u64 (*generic)(u64 crc, const u8 *p, size_t len);
+};
+
+static u64 crc_t10dif_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return crc_t10dif_update(crc, p, len);
+}
+
+static u64 crc_t10dif_generic_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return crc_t10dif_generic(crc, p, len);
+}
+
+static u64 crc32c_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return crc32c(crc, p, len);
+}
+
+static u64 crc32c_generic_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return __crc32c_le(crc, p, len);
+}
+
+static u64 crc32_le_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return crc32_le(crc, p, len);
+}
+
+static u64 crc64_rocksoft_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return crc64_rocksoft_update(crc, p, len);
+}
+
+static u64 crc64_rocksoft_generic_wrapper(u64 crc, const u8 *p, size_t len)
+{
+	return crc64_rocksoft_generic(crc, p, len);
+}
+
+static const struct crc_variant crc_variants[] = {
+	{ "crc_t10dif", crc_t10dif_wrapper, crc_t10dif_generic_wrapper },
+	{ "crc32c", crc32c_wrapper, crc32c_generic_wrapper },
+	{ "crc32_le", crc32_le_wrapper, NULL },
+	{ "crc64_rocksoft", crc64_rocksoft_wrapper,
+	  crc64_rocksoft_generic_wrapper },
+};
+
+static const size_t crc_bench_lens[] = { 64, 512, 4096, 65536 };
+
+struct crc_test_ctx {
+	u8 *buf;
+};
+
+static int crc_test_init(struct kunit *test)
+{
+	struct crc_test_ctx *ctx;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx);
+
+	ctx->buf = kunit_kmalloc(test, CRC_TEST_BUF_LEN, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx->buf);
+	get_random_bytes(ctx->buf, CRC_TEST_BUF_LEN);
+
+	test->priv = ctx;
+	return 0;
+}
+
+/* uniform enough in [0, ceil) for picking offsets and lengths */
+static u32 crc_rand_below(u32 ceil)
+{
+	return (u32)(((u64)get_random_u32() * ceil) >> 32);
+}
+
+/*
+ * Compare against the generic code over random offsets and lengths, both in
+ * one call and split in two, to catch alignment and tail handling bugs in the
+ * accelerated versions.
+ */
+static void crc_test_matches_generic(struct kunit *test)
+{
+	struct crc_test_ctx *ctx = test->priv;
+	size_t i, v;
+
+	for (v = 0; v < ARRAY_SIZE(crc_variants); v++) {
+		const struct crc_variant *var = &crc_variants[v];
+
+		if (!var->generic)
+			continue;
+
+		for (i = 0; i < CRC_TEST_ITERS; i++) {
+			size_t off = crc_rand_below(64);
+			size_t len = crc_rand_below(CRC_TEST_BUF_LEN - off);
+			size_t split = len ? crc_rand_below(len) : 0;
+			u64 seed = get_random_u32();
+			u64 expect, crc;
+
+			expect = var->generic(seed, ctx->buf + off, len);
+
+			crc = var->func(seed, ctx->buf + off, len);
+			KUNIT_EXPECT_EQ_MSG(test, crc, expect,
+					    "%s: off=%zu len=%zu", var->name,
+					    off, len);
+
+			crc = var->func(seed, ctx->buf + off, split);
+			crc = var->func(crc, ctx->buf + off + split,
+					len - split);
+			KUNIT_EXPECT_EQ_MSG(test, crc, expect,
+					    "%s: off=%zu len=%zu split=%zu",
+					    var->name, off, len, split);
+		}
+	}
+}
+
+static void crc_test_benchmark(struct kunit *test)
+{
+	struct crc_test_ctx *ctx = test->priv;
+	size_t l, v;
+
+	if (!IS_ENABLED(CONFIG_CRC_KUNIT_BENCHMARK))
+		kunit_skip(test, "not enabled");
+
+	for (v = 0; v < ARRAY_SIZE(crc_variants); v++) {
+		const struct crc_variant *var = &crc_variants[v];
+
+		for (l = 0; l < ARRAY_SIZE(crc_bench_lens); l++) {
+			size_t len = crc_bench_lens[l];
+			size_t i, iters = CRC_BENCH_BYTES / len;
+			u64 crc = 0, t;
+
+			/* warm up caches and any lazily set up state */
+			crc = var->func(crc, ctx->buf, len);
+
+			t = ktime_get_ns();
+			for (i = 0; i < iters; i++)
+				crc = var->func(crc, ctx->buf, len);
+			t = ktime_get_ns() - t;
+
+			KUNIT_ASSERT_NE(test, t, 0ULL);
+			/* print the crc so the loop isn't optimized out */
+			kunit_info(test, "%s len=%zu: %llu MB/s (crc %llx)\n",
+				   var->name, len,
+				   div64_u64((u64)CRC_BENCH_BYTES * 1000, t),
+				   crc);
+		}
+	}
+}
+
+static struct kunit_case crc_test_cases[] = {
+	KUNIT_CASE(crc_test_matches_generic),
+	KUNIT_CASE(crc_test_benchmark),
+	{}
+};
+
+static struct kunit_suite crc_test_suite = {
+	.name = "crc",
+	.init = crc_test_init,
+	.test_cases = crc_test_cases,
+};
+
+kunit_test_suite(crc_test_suite);
+
+MODULE_DESCRIPTION("Test cases and benchmark for library CRC functions");
+MODULE_LICENSE("GPL");
@@ -84,6 +84,13 @@ void folio_rotate_reclaimable(struct folio *folio);
 bool __folio_end_writeback(struct folio *folio);
 void deactivate_file_folio(struct folio *folio);
 
+/*
+ * The per-cpu LRU and mlock batches hold their pages off the LRU with an
+ * elevated refcount, which gets in the way of compaction and migration.
+ * Keep them at the old PAGEVEC_SIZE rather than the full batch size.
+ */
+#define LRU_BATCH_SIZE	15
+
 void free_pgtables(struct mmu_gather *tlb, struct vm_area_struct *start_vma,
 		unsigned long floor, unsigned long ceiling);
 void pmd_install(struct mm_struct *mm, pmd_t *pmd, pgtable_t *pte);
@@ -493,7 +493,18 @@ void mempool_free(void *element, mempool_t *pool)
 		if (likely(pool->curr_nr < pool->min_nr)) {
 			add_element(pool, element);
 			spin_unlock_irqrestore(&pool->lock, flags);
-			wake_up(&pool->wait);
+			/*
+			 * Waiters queue themselves on @pool->wait while
+			 * holding @pool->lock and only after finding the
+			 * reserve empty, so the lock orders that against
+			 * the add_element() above: either the waiter is
+			 * visible here or it will see the new element.
+			 * Refilling the reserve is common under memory
+			 * pressure, don't bounce the waitqueue lock when
+			 * nobody is sleeping.
+			 */
+			if (waitqueue_active(&pool->wait))
+				wake_up(&pool->wait);
 			return;
 		}
 		spin_unlock_irqrestore(&pool->lock, flags);
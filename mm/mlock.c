@@ -256,6 +256,7 @@ void mlock_folio(struct folio *folio)
 
 	folio_get(folio);
 	if (!pagevec_add(pvec, mlock_lru(&folio->page)) ||
+	    pagevec_count(pvec) >= LRU_BATCH_SIZE ||
 	    folio_test_large(folio) || lru_cache_disabled())
 		mlock_pagevec(pvec);
 	local_unlock(&mlock_pvec.lock);
@@ -278,6 +279,7 @@ void mlock_new_page(struct page *page)
 
 	get_page(page);
 	if (!pagevec_add(pvec, mlock_new(page)) ||
+	    pagevec_count(pvec) >= LRU_BATCH_SIZE ||
 	    PageHead(page) || lru_cache_disabled())
 		mlock_pagevec(pvec);
 	local_unlock(&mlock_pvec.lock);
@@ -300,6 +302,7 @@ void munlock_page(struct page *page)
 
 	get_page(page);
 	if (!pagevec_add(pvec, page) ||
+	    pagevec_count(pvec) >= LRU_BATCH_SIZE ||
 	    PageHead(page) || lru_cache_disabled())
 		mlock_pagevec(pvec);
 	local_unlock(&mlock_pvec.lock);
@@ -235,8 +235,14 @@ static void bio_associate_blkg_from_page(struct bio *bio, struct page *page)
 #define bio_associate_blkg_from_page(bio, page)		do { } while (0)
 #endif /* CONFIG_MEMCG && CONFIG_BLK_CGROUP */
 
+/*
+ * Batches swap I/O.  Swap files using ->swap_rw() submit the batch through
+ * @iocb; block device reads (where @iocb.ki_filp is NULL) are batched into
+ * @bio, which uses @bvec as its inline vector table.
+ */
 struct swap_iocb {
 	struct kiocb		iocb;
+	struct bio		bio;
 	struct bio_vec		bvec[SWAP_CLUSTER_MAX];
 	int			pages;
 	int			len;
@@ -445,6 +451,72 @@ static void swap_readpage_fs(struct page *page,
 		*plug = sio;
 }
 
+static void end_swap_bio_read_batch(struct bio *bio)
+{
+	struct swap_iocb *sio = container_of(bio, struct swap_iocb, bio);
+	int p;
+
+	if (bio->bi_status)
+		pr_alert_ratelimited("Read-error on swap-device (%u:%u:%llu)\n",
+				     MAJOR(bio_dev(bio)), MINOR(bio_dev(bio)),
+				     (unsigned long long)bio->bi_iter.bi_sector);
+
+	for (p = 0; p < sio->pages; p++) {
+		struct page *page = sio->bvec[p].bv_page;
+
+		if (bio->bi_status) {
+			SetPageError(page);
+			ClearPageUptodate(page);
+		} else {
+			SetPageUptodate(page);
+		}
+		unlock_page(page);
+	}
+	bio_uninit(bio);
+	mempool_free(sio, sio_pool);
+}
+
+/*
+ * Readahead reads swap slots in ascending order, so instead of allocating
+ * and submitting a bio per page, append pages to the plugged bio as long as
+ * they are contiguous on the device and submit it on unplug.
+ */
+static void swap_readpage_bdev_batch(struct page *page,
+				     struct swap_info_struct *sis,
+				     struct swap_iocb **plug)
+{
+	struct swap_iocb *sio = *plug;
+	sector_t sector = swap_page_sector(page);
+
+	if (sio) {
+		if (sio->iocb.ki_filp || sio->bio.bi_bdev != sis->bdev ||
+		    bio_end_sector(&sio->bio) != sector) {
+			swap_read_unplug(sio);
+			sio = NULL;
+		}
+	}
+	if (!sio) {
+		sio = mempool_alloc(sio_pool, GFP_KERNEL);
+		sio->iocb.ki_filp = NULL;
+		bio_init(&sio->bio, sis->bdev, sio->bvec,
+			 ARRAY_SIZE(sio->bvec), REQ_OP_READ);
+		sio->bio.bi_iter.bi_sector = sector;
+		sio->bio.bi_end_io = end_swap_bio_read_batch;
+		sio->pages = 0;
+		sio->len = 0;
+	}
+	/* Never merge, so bvec[] stays indexed by page for completion. */
+	__bio_add_page(&sio->bio, page, thp_size(page), 0);
+	sio->len += thp_size(page);
+	sio->pages += 1;
+	count_vm_event(PSWPIN);
+	if (sio->pages == ARRAY_SIZE(sio->bvec)) {
+		submit_bio(&sio->bio);
+		sio = NULL;
+	}
+	*plug = sio;
+}
+
 int swap_readpage(struct page *page, bool synchronous,
 		  struct swap_iocb **plug)
 {
@@ -487,6 +559,11 @@ int swap_readpage(struct page *page, bool synchronous,
 	}
 
 	ret = 0;
+	if (!synchronous && plug && sio_pool) {
+		swap_readpage_bdev_batch(page, sis, plug);
+		goto out;
+	}
+
 	bio = bio_alloc(sis->bdev, 1, REQ_OP_READ, GFP_KERNEL);
 	bio->bi_iter.bi_sector = swap_page_sector(page);
 	bio->bi_end_io = end_swap_bio_read;
@@ -522,9 +599,15 @@ int swap_readpage(struct page *page, bool synchronous,
 void __swap_read_unplug(struct swap_iocb *sio)
 {
 	struct iov_iter from;
-	struct address_space *mapping = sio->iocb.ki_filp->f_mapping;
+	struct address_space *mapping;
 	int ret;
 
+	if (!sio->iocb.ki_filp) {
+		submit_bio(&sio->bio);
+		return;
+	}
+
+	mapping = sio->iocb.ki_filp->f_mapping;
 	iov_iter_bvec(&from, READ, sio->bvec, sio->pages, sio->len);
 	ret = mapping->a_ops->swap_rw(&sio->iocb, &from);
 	if (ret != -EIOCBQUEUED)
@@ -455,19 +455,6 @@ static int try_context_readahead(struct address_space *mapping,
 	return 1;
 }
 
-/*
- * There are some parts of the kernel which assume that PMD entries
- * are exactly HPAGE_PMD_ORDER.  Those should be fixed, but until then,
- * limit the maximum allocation order to PMD size.  I'm not aware of any
- * assumptions about maximum order if THP are disabled, but 8 seems like
- * a good order (that's 1MB if you're using 4kB pages)
- */
-#ifdef CONFIG_TRANSPARENT_HUGEPAGE
-#define MAX_PAGECACHE_ORDER	HPAGE_PMD_ORDER
-#else
-#define MAX_PAGECACHE_ORDER	8
-#endif
-
 static inline int ra_alloc_folio(struct readahead_control *ractl, pgoff_t index,
 		pgoff_t mark, unsigned int order, gfp_t gfp)
 {
@@ -672,6 +659,26 @@ static void ondemand_readahead(struct readahead_control *ractl,
 	page_cache_ra_order(ractl, ra, order);
 }
 
+/*
+ * Account readahead pages we didn't issue because the task's blkcg is
+ * congested, both globally and to the task's memcg, so the effect of IO
+ * control on the page cache shows up in memory.stat.
+ */
+static void ra_account_cgroup_trimmed(unsigned long nr_pages)
+{
+	struct mem_cgroup *memcg;
+
+	if (!nr_pages)
+		return;
+
+	count_vm_events(RA_CGROUP_TRIMMED, nr_pages);
+	rcu_read_lock();
+	memcg = mem_cgroup_from_task(current);
+	if (memcg)
+		count_memcg_events(memcg, RA_CGROUP_TRIMMED, nr_pages);
+	rcu_read_unlock();
+}
+
 void page_cache_sync_ra(struct readahead_control *ractl,
 		unsigned long req_count)
 {
@@ -686,6 +693,19 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	if (!ractl->ra->ra_pages || blk_cgroup_congested()) {
 		if (!ractl->file)
 			return;
+		/*
+		 * Only the page being read is issued.  Count the rest of the
+		 * window readahead would have read, which for anything but
+		 * FMODE_RANDOM is grown up to ra_pages.
+		 */
+		if (ractl->ra->ra_pages) {
+			unsigned long window = req_count;
+
+			if (!do_forced_ra)
+				window = max_t(unsigned long, window,
+					       ractl->ra->ra_pages);
+			ra_account_cgroup_trimmed(window - 1);
+		}
 		req_count = 1;
 		do_forced_ra = true;
 	}
@@ -715,8 +735,12 @@ void page_cache_async_ra(struct readahead_control *ractl,
 
 	folio_clear_readahead(folio);
 
-	if (blk_cgroup_congested())
+	if (blk_cgroup_congested()) {
+		/* the window ondemand_readahead() would have ramped up to */
+		ra_account_cgroup_trimmed(get_next_ra_size(ractl->ra,
+							   ractl->ra->ra_pages));
 		return;
+	}
 
 	ondemand_readahead(ractl, folio, req_count);
 }
@@ -1070,6 +1070,7 @@ int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 		plist_requeue(&si->avail_lists[node], &swap_avail_heads[node]);
 		spin_unlock(&swap_avail_lock);
 		spin_lock(&si->lock);
+		count_vm_event(SWAP_SLOT_ALLOC_LOCK);
 		if (!si->highest_bit || !(si->flags & SWP_WRITEOK)) {
 			spin_lock(&swap_avail_lock);
 			if (plist_node_empty(&si->avail_lists[node])) {
@@ -1121,6 +1122,7 @@ int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 	if (n_ret < n_goal)
 		atomic_long_add((long)(n_goal - n_ret) * size,
 				&nr_swap_pages);
+	count_vm_events(SWAP_SLOT_ALLOC, n_ret);
 noswap:
 	return n_ret;
 }
@@ -1419,12 +1421,15 @@ void swapcache_free_entries(swp_entry_t *entries, int n)
 		sort(entries, n, sizeof(entries[0]), swp_entry_cmp, NULL);
 	for (i = 0; i < n; ++i) {
 		p = swap_info_get_cont(entries[i], prev);
+		if (p && p != prev)
+			count_vm_event(SWAP_SLOT_FREE_LOCK);
 		if (p)
 			swap_entry_free(p, entries[i]);
 		prev = p;
 	}
 	if (p)
 		spin_unlock(&p->lock);
+	count_vm_events(SWAP_SLOT_FREE, n);
 }
 
 /*
@@ -2947,6 +2952,12 @@ static int setup_swap_map_and_extents(struct swap_info_struct *p,
 		nr_extents = setup_swap_extents(p, span);
 		if (nr_extents < 0)
 			return nr_extents;
+		/*
+		 * The pool also batches block device swap readahead into
+		 * multi-page bios.  That is only an optimisation, so carry on
+		 * with single page reads if it cannot be allocated.
+		 */
+		sio_pool_init();
 		nr_good_pages = p->pages;
 	}
 	if (!nr_good_pages) {
@@ -1393,9 +1393,14 @@ const char * const vmstat_text[] = {
 	"vmacache_find_calls",
 	"vmacache_find_hits",
 #endif
+	"ra_cgroup_trimmed",
 #ifdef CONFIG_SWAP
 	"swap_ra",
 	"swap_ra_hit",
+	"swap_slot_alloc",
+	"swap_slot_alloc_lock",
+	"swap_slot_free",
+	"swap_slot_free_lock",
 #ifdef CONFIG_KSM
 	"ksm_swpin_copy",
 #endif
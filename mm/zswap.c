@@ -21,7 +21,7 @@
 #include <linux/types.h>
 #include <linux/atomic.h>
 #include <linux/frontswap.h>
-#include <linux/rbtree.h>
+#include <linux/xarray.h>
 #include <linux/swap.h>
 #include <linux/crypto.h>
 #include <linux/scatterlist.h>
@@ -164,8 +164,7 @@ struct zswap_pool {
  * This structure contains the metadata for tracking a single compressed
  * page within zswap.
  *
- * rbnode - links the entry into red-black tree for the appropriate swap type
- * offset - the swap offset for the entry.  Index into the red-black tree.
+ * offset - the swap offset for the entry.  Index into the tree's xarray.
  * refcount - the number of outstanding reference to the entry. This is needed
  *            to protect against premature freeing of the entry by code
  *            concurrent calls to load, invalidate, and writeback.  The lock
@@ -179,7 +178,6 @@ struct zswap_pool {
  * value - value of the same-value filled pages which have same content
  */
 struct zswap_entry {
-	struct rb_node rbnode;
 	pgoff_t offset;
 	int refcount;
 	unsigned int length;
@@ -196,13 +194,14 @@ struct zswap_header {
 };
 
 /*
- * The tree lock in the zswap_tree struct protects a few things:
- * - the rbtree
- * - the refcount field of each entry in the tree
+ * The xarray indexes entries by swap offset.  Its lock is also the tree
+ * lock: it protects the refcount field of each entry in the tree, so it must
+ * be held across a lookup that takes a reference and across replacing an
+ * entry, so that the replaced entry's reference is dropped together with its
+ * removal.
  */
 struct zswap_tree {
-	struct rb_root rbroot;
-	spinlock_t lock;
+	struct xarray xarray;
 };
 
 static struct zswap_tree *zswap_trees[MAX_SWAPFILES];
@@ -290,7 +289,6 @@ static struct zswap_entry *zswap_entry_cache_alloc(gfp_t gfp)
 	if (!entry)
 		return NULL;
 	entry->refcount = 1;
-	RB_CLEAR_NODE(&entry->rbnode);
 	return entry;
 }
 
@@ -300,58 +298,21 @@ static void zswap_entry_cache_free(struct zswap_entry *entry)
 }
 
 /*********************************
-* rbtree functions
+* xarray functions
 **********************************/
-static struct zswap_entry *zswap_rb_search(struct rb_root *root, pgoff_t offset)
+static struct zswap_entry *zswap_xa_search(struct zswap_tree *tree,
+					   pgoff_t offset)
 {
-	struct rb_node *node = root->rb_node;
-	struct zswap_entry *entry;
-
-	while (node) {
-		entry = rb_entry(node, struct zswap_entry, rbnode);
-		if (entry->offset > offset)
-			node = node->rb_left;
-		else if (entry->offset < offset)
-			node = node->rb_right;
-		else
-			return entry;
-	}
-	return NULL;
+	return xa_load(&tree->xarray, offset);
 }
 
 /*
- * In the case that a entry with the same offset is found, a pointer to
- * the existing entry is stored in dupentry and the function returns -EEXIST
+ * Remove @entry from the index, unless its offset has since been reused for
+ * a newer entry, which must be left in place.
  */
-static int zswap_rb_insert(struct rb_root *root, struct zswap_entry *entry,
-			struct zswap_entry **dupentry)
-{
-	struct rb_node **link = &root->rb_node, *parent = NULL;
-	struct zswap_entry *myentry;
-
-	while (*link) {
-		parent = *link;
-		myentry = rb_entry(parent, struct zswap_entry, rbnode);
-		if (myentry->offset > entry->offset)
-			link = &(*link)->rb_left;
-		else if (myentry->offset < entry->offset)
-			link = &(*link)->rb_right;
-		else {
-			*dupentry = myentry;
-			return -EEXIST;
-		}
-	}
-	rb_link_node(&entry->rbnode, parent, link);
-	rb_insert_color(&entry->rbnode, root);
-	return 0;
-}
-
-static void zswap_rb_erase(struct rb_root *root, struct zswap_entry *entry)
+static void zswap_xa_erase(struct zswap_tree *tree, struct zswap_entry *entry)
 {
-	if (!RB_EMPTY_NODE(&entry->rbnode)) {
-		rb_erase(&entry->rbnode, root);
-		RB_CLEAR_NODE(&entry->rbnode);
-	}
+	__xa_cmpxchg(&tree->xarray, entry->offset, entry, NULL, GFP_ATOMIC);
 }
 
 /*
@@ -391,18 +352,18 @@ static void zswap_entry_put(struct zswap_tree *tree,
 
 	BUG_ON(refcount < 0);
 	if (refcount == 0) {
-		zswap_rb_erase(&tree->rbroot, entry);
+		zswap_xa_erase(tree, entry);
 		zswap_free_entry(entry);
 	}
 }
 
 /* caller must hold the tree lock */
-static struct zswap_entry *zswap_entry_find_get(struct rb_root *root,
+static struct zswap_entry *zswap_entry_find_get(struct zswap_tree *tree,
 				pgoff_t offset)
 {
 	struct zswap_entry *entry;
 
-	entry = zswap_rb_search(root, offset);
+	entry = zswap_xa_search(tree, offset);
 	if (entry)
 		zswap_entry_get(entry);
 
@@ -970,16 +931,16 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	offset = swp_offset(swpentry);
 
 	/* find and ref zswap entry */
-	spin_lock(&tree->lock);
-	entry = zswap_entry_find_get(&tree->rbroot, offset);
+	xa_lock(&tree->xarray);
+	entry = zswap_entry_find_get(tree, offset);
 	if (!entry) {
 		/* entry was invalidated */
-		spin_unlock(&tree->lock);
+		xa_unlock(&tree->xarray);
 		zpool_unmap_handle(pool, handle);
 		kfree(tmp);
 		return 0;
 	}
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
 	BUG_ON(offset != entry->offset);
 
 	src = (u8 *)zhdr + sizeof(struct zswap_header);
@@ -1030,7 +991,7 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	put_page(page);
 	zswap_written_back_pages++;
 
-	spin_lock(&tree->lock);
+	xa_lock(&tree->xarray);
 	/* drop local reference */
 	zswap_entry_put(tree, entry);
 
@@ -1041,9 +1002,9 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	*     because invalidate happened during writeback
 	*  search the tree and free the entry if find entry
 	*/
-	if (entry == zswap_rb_search(&tree->rbroot, offset))
+	if (entry == zswap_xa_search(tree, offset))
 		zswap_entry_put(tree, entry);
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
 
 	goto end;
 
@@ -1055,9 +1016,9 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	* it is also okay to return !0
 	*/
 fail:
-	spin_lock(&tree->lock);
+	xa_lock(&tree->xarray);
 	zswap_entry_put(tree, entry);
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
 
 end:
 	if (zpool_can_sleep_mapped(pool))
@@ -1099,6 +1060,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 {
 	struct zswap_tree *tree = zswap_trees[type];
 	struct zswap_entry *entry, *dupentry;
+	XA_STATE(xas, &tree->xarray, offset);
 	struct scatterlist input, output;
 	struct crypto_acomp_ctx *acomp_ctx;
 	struct obj_cgroup *objcg = NULL;
@@ -1233,24 +1195,34 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 
 insert_entry:
 	entry->objcg = objcg;
-	if (objcg) {
+	if (objcg)
 		obj_cgroup_charge_zswap(objcg, entry->length);
-		/* Account before objcg ref is moved to tree */
-		count_objcg_event(objcg, ZSWPOUT);
-	}
 
-	/* map */
-	spin_lock(&tree->lock);
+	/*
+	 * map: replace any existing entry and drop its initial reference in
+	 * one tree lock section, so that writeback can't put and free it in
+	 * between.  Node allocations happen outside the lock in xas_nomem().
+	 */
 	do {
-		ret = zswap_rb_insert(&tree->rbroot, entry, &dupentry);
-		if (ret == -EEXIST) {
-			zswap_duplicate_entry++;
-			/* remove from rbtree */
-			zswap_rb_erase(&tree->rbroot, dupentry);
-			zswap_entry_put(tree, dupentry);
+		xas_lock(&xas);
+		dupentry = xas_store(&xas, entry);
+		if (!xas_error(&xas)) {
+			/* the entry pins objcg until it's put under the lock */
+			if (objcg)
+				count_objcg_event(objcg, ZSWPOUT);
+			if (dupentry) {
+				zswap_duplicate_entry++;
+				zswap_entry_put(tree, dupentry);
+			}
 		}
-	} while (ret == -EEXIST);
-	spin_unlock(&tree->lock);
+		xas_unlock(&xas);
+	} while (xas_nomem(&xas, GFP_KERNEL));
+
+	ret = xas_error(&xas);
+	if (ret) {
+		zswap_reject_alloc_fail++;
+		goto free_entry;
+	}
 
 	/* update stats */
 	atomic_inc(&zswap_stored_pages);
@@ -1259,6 +1231,17 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 
 	return 0;
 
+free_entry:
+	if (objcg)
+		obj_cgroup_uncharge_zswap(objcg, entry->length);
+	if (entry->length) {
+		zpool_free(entry->pool->zpool, entry->handle);
+		zswap_pool_put(entry->pool);
+	} else {
+		atomic_dec(&zswap_same_filled_pages);
+	}
+	goto freepage;
+
 put_dstmem:
 	mutex_unlock(acomp_ctx->mutex);
 	zswap_pool_put(entry->pool);
@@ -1293,14 +1276,14 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	int ret;
 
 	/* find */
-	spin_lock(&tree->lock);
-	entry = zswap_entry_find_get(&tree->rbroot, offset);
+	xa_lock(&tree->xarray);
+	entry = zswap_entry_find_get(tree, offset);
 	if (!entry) {
 		/* entry was written back */
-		spin_unlock(&tree->lock);
+		xa_unlock(&tree->xarray);
 		return -1;
 	}
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
 
 	if (!entry->length) {
 		dst = kmap_atomic(page);
@@ -1350,9 +1333,9 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	if (entry->objcg)
 		count_objcg_event(entry->objcg, ZSWPIN);
 freeentry:
-	spin_lock(&tree->lock);
+	xa_lock(&tree->xarray);
 	zswap_entry_put(tree, entry);
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
 
 	return ret;
 }
@@ -1364,38 +1347,39 @@ static void zswap_frontswap_invalidate_page(unsigned type, pgoff_t offset)
 	struct zswap_entry *entry;
 
 	/* find */
-	spin_lock(&tree->lock);
-	entry = zswap_rb_search(&tree->rbroot, offset);
+	xa_lock(&tree->xarray);
+	entry = zswap_xa_search(tree, offset);
 	if (!entry) {
 		/* entry was written back */
-		spin_unlock(&tree->lock);
+		xa_unlock(&tree->xarray);
 		return;
 	}
 
-	/* remove from rbtree */
-	zswap_rb_erase(&tree->rbroot, entry);
+	/* remove from xarray */
+	zswap_xa_erase(tree, entry);
 
 	/* drop the initial reference from entry creation */
 	zswap_entry_put(tree, entry);
 
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
 }
 
 /* frees all zswap entries for the given swap type */
 static void zswap_frontswap_invalidate_area(unsigned type)
 {
 	struct zswap_tree *tree = zswap_trees[type];
-	struct zswap_entry *entry, *n;
+	struct zswap_entry *entry;
+	unsigned long index;
 
 	if (!tree)
 		return;
 
 	/* walk the tree and free everything */
-	spin_lock(&tree->lock);
-	rbtree_postorder_for_each_entry_safe(entry, n, &tree->rbroot, rbnode)
+	xa_lock(&tree->xarray);
+	xa_for_each(&tree->xarray, index, entry)
 		zswap_free_entry(entry);
-	tree->rbroot = RB_ROOT;
-	spin_unlock(&tree->lock);
+	xa_unlock(&tree->xarray);
+	xa_destroy(&tree->xarray);
 	kfree(tree);
 	zswap_trees[type] = NULL;
 }
@@ -1410,8 +1394,7 @@ static void zswap_frontswap_init(unsigned type)
 		return;
 	}
 
-	tree->rbroot = RB_ROOT;
-	spin_lock_init(&tree->lock);
+	xa_init(&tree->xarray);
 	zswap_trees[type] = tree;
 }
 
@@ -0,0 +1,86 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Check that data written to a RAM block device with copies handed to
+# async_memcpy() reads back intact, for several offload thresholds.
+#
+# The copies are only offloaded when a memcpy capable DMA channel is
+# registered, and this test does not register one.  Without one
+# async_memcpy() copies synchronously on the CPU, so the test covers that
+# fallback, the chaining of a bio's copies and the bio remaining count
+# handling.  Asynchronous DMA completion is untested unless the machine
+# running the test has a memcpy capable DMA engine.
+
+# Kselftest framework requirement - SKIP code is 4.
+ksft_skip=4
+
+PARAM=/sys/module/brd/parameters/dma_copy_min
+DEV=/dev/ram0
+TMP=$(mktemp -d)
+ret=0
+
+cleanup()
+{
+	rm -rf "$TMP"
+	/sbin/modprobe -q -r brd
+}
+
+if [ $UID != 0 ]; then
+	echo "Please run brd_dma_copy test as root [SKIP]"
+	exit $ksft_skip
+fi
+
+if [ -d /sys/module/brd ]; then
+	echo "brd_dma_copy: brd is already loaded or built in [SKIP]"
+	exit $ksft_skip
+fi
+
+if ! /sbin/modprobe -q brd rd_nr=1 rd_size=65536; then
+	echo "brd_dma_copy: module brd is not found [SKIP]"
+	exit $ksft_skip
+fi
+trap cleanup EXIT
+
+if [ ! -w $PARAM ]; then
+	echo "brd_dma_copy: CONFIG_BLK_DEV_RAM_ASYNC_COPY is not enabled [SKIP]"
+	exit $ksft_skip
+fi
+
+if [ -z "$(ls /sys/class/dma 2>/dev/null)" ]; then
+	echo "brd_dma_copy: no DMA channels, asynchronous DMA completion is untested"
+fi
+
+dd if=/dev/urandom of="$TMP/data" bs=1M count=32 status=none
+
+# 65536 is only reached by multi-page bvecs
+for min in 512 4096 65536 0; do
+	echo $min > $PARAM
+
+	dd if="$TMP/data" of=$DEV bs=1M oflag=direct status=none
+	dd if=$DEV of="$TMP/out" bs=1M count=32 iflag=direct status=none
+	if ! cmp -s "$TMP/data" "$TMP/out"; then
+		echo "brd_dma_copy: data mismatch with dma_copy_min=$min [FAIL]"
+		ret=1
+	fi
+
+	# never written, so must read back as zeroes
+	dd if=$DEV of="$TMP/out" bs=1M skip=32 count=32 iflag=direct \
+		status=none
+	if ! cmp -s "$TMP/out" <(head -c 32M /dev/zero); then
+		echo "brd_dma_copy: hole not zeroed with dma_copy_min=$min [FAIL]"
+		ret=1
+	fi
+
+	# unaligned to the page size, so copies straddle two brd pages
+	dd if="$TMP/data" of=$DEV bs=1M count=2 seek=512 \
+		oflag=direct,seek_bytes status=none
+	dd if=$DEV of="$TMP/out" bs=1M count=2 skip=512 \
+		iflag=direct,skip_bytes status=none
+	if ! cmp -s "$TMP/out" <(head -c 2M "$TMP/data"); then
+		echo "brd_dma_copy: unaligned mismatch with dma_copy_min=$min [FAIL]"
+		ret=1
+	fi
+done
+
+[ $ret -eq 0 ] && echo "brd_dma_copy: ok"
+exit $ret